@@ -1,7 +1,12 @@
+#pragma once
+
+#include <array>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <mutex>
 #include <new>
+#include <thread>
 
 #if defined(__aarch64__) || defined(__arm64__)
 #include <arm_acle.h>
@@ -13,6 +18,15 @@ static constexpr size_t k_spinlock_alignment{std::hardware_destructive_interfere
 static constexpr size_t k_spinlock_alignment{64};
 #endif
 
+// Signals the core that it is in a spin-wait loop.
+inline void cpu_relax() noexcept {
+#if defined(__aarch64__) || defined(__arm64__)
+    __builtin_arm_yield();
+#else
+    __builtin_ia32_pause();
+#endif
+}
+
 class alignas(k_spinlock_alignment) Spinlock {
   public:
     Spinlock() noexcept : state_(0) {}
@@ -29,11 +43,7 @@ class alignas(k_spinlock_alignment) Spinlock {
             // 1. Busy-wait with 'yield' to save power and signal the hardware
             // that this core is in a spin-loop.
             while (state_.load(std::memory_order_relaxed) != 0) {
-#if defined(__aarch64__) || defined(__arm64__)
-                __builtin_arm_yield();
-#else
-                __builtin_ia32_pause();
-#endif
+                cpu_relax();
             }
 
             // 2. Try to grab the lock again
@@ -60,12 +70,182 @@ class alignas(k_spinlock_alignment) Spinlock {
     std::atomic<uint32_t> state_;
 };
 
-class [[nodiscard]] SpinlockGuard {
+// MCS queue lock. Each waiter enqueues its own node and spins on that node's cache line, so a
+// release touches one waiter instead of every core spinning on the lock word. Queue nodes come from
+// a small per-thread array. A thread that holds more MCS locks at once than the array has nodes
+// never allocates: it takes the lock's own overflow node, test-and-test-and-set style, once the
+// queue is empty, so it may wait behind queued threads for longer than they wait for each other.
+class alignas(k_spinlock_alignment) McsLock {
+  public:
+    McsLock() noexcept = default;
+
+    McsLock(const McsLock&) = delete;
+    McsLock& operator=(const McsLock&) = delete;
+
+    void lock() noexcept {
+        QueueNode* node(acquire_node());
+
+        if (!node) [[unlikely]] {
+            lock_overflow();
+            return;
+        }
+
+        QueueNode* previous(tail_.exchange(node, std::memory_order_acq_rel));
+
+        if (previous) {
+            previous->next.store(node, std::memory_order_release);
+
+            // Handoff goes to this thread specifically, so a waiter that spins while it is
+            // descheduled stalls everyone queued behind it; yield now and then in case the
+            // holder is waiting for a core.
+            for (size_t spin{1}; node->locked.load(std::memory_order_acquire); ++spin) {
+                if (spin % k_yield_spin == 0) {
+                    std::this_thread::yield();
+                }
+                else {
+                    cpu_relax();
+                }
+            }
+        }
+
+        holder_ = node;
+    }
+
+    bool try_lock() noexcept {
+        QueueNode* node(acquire_node());
+        QueueNode* expected{nullptr};
+
+        if (!node) [[unlikely]] {
+            node = &overflow_node_;
+        }
+
+        if (!tail_.compare_exchange_strong(
+                    expected,
+                    node,
+                    std::memory_order_acquire,
+                    std::memory_order_relaxed
+            )) {
+            release_node(node);
+            return false;
+        }
+
+        holder_ = node;
+        return true;
+    }
+
+    void unlock() noexcept {
+        QueueNode* node(holder_);
+        QueueNode* next(node->next.load(std::memory_order_acquire));
+
+        if (!next) {
+            QueueNode* expected(node);
+
+            if (tail_.compare_exchange_strong(
+                        expected,
+                        nullptr,
+                        std::memory_order_release,
+                        std::memory_order_relaxed
+                )) {
+                release_node(node);
+                return;
+            }
+
+            // A successor swapped itself in but has not linked behind this node yet.
+            while (!(next = node->next.load(std::memory_order_acquire))) {
+                cpu_relax();
+            }
+        }
+
+        // The overflow node is free again once the successor owns the lock, so it must not
+        // keep a stale link for the next thread that takes it.
+        if (node == &overflow_node_) [[unlikely]] {
+            node->next.store(nullptr, std::memory_order_relaxed);
+        }
+
+        next->locked.store(false, std::memory_order_release);
+        release_node(node);
+    }
+
+  private:
+    static constexpr size_t k_nodes_per_thread{8};
+    static constexpr size_t k_yield_spin{64};
+
+    struct alignas(k_spinlock_alignment) QueueNode {
+        std::atomic<QueueNode*> next{nullptr};
+        std::atomic<bool> locked{false};
+        bool in_use{false};
+        // Set only on overflow nodes, which belong to the lock rather than a thread.
+        bool shared{false};
+    };
+
+    // Returns nullptr when the calling thread already holds k_nodes_per_thread MCS locks.
+    static QueueNode* acquire_node() noexcept {
+        thread_local std::array<QueueNode, k_nodes_per_thread> nodes;
+
+        for (QueueNode& node : nodes) {
+            if (!node.in_use) {
+                node.in_use = true;
+                node.next.store(nullptr, std::memory_order_relaxed);
+                node.locked.store(true, std::memory_order_relaxed);
+                return &node;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Nothing else can reach the overflow node while the tail is empty, and a thread that
+    // handed it to a successor has already cleared its link.
+    void lock_overflow() noexcept {
+        for (size_t spin{1};; ++spin) {
+            QueueNode* expected{nullptr};
+
+            if (!tail_.load(std::memory_order_relaxed) &&
+                tail_.compare_exchange_weak(
+                        expected,
+                        &overflow_node_,
+                        std::memory_order_acquire,
+                        std::memory_order_relaxed
+                )) {
+                holder_ = &overflow_node_;
+                return;
+            }
+
+            if (spin % k_yield_spin == 0) {
+                std::this_thread::yield();
+            }
+            else {
+                cpu_relax();
+            }
+        }
+    }
+
+    // Only called once no other thread can reach the node: the tail has moved off it, or the
+    // successor has been handed the lock.
+    static void release_node(QueueNode* node) noexcept {
+        if (node->shared) [[unlikely]] {
+            return;
+        }
+
+        node->in_use = false;
+    }
+
+    std::atomic<QueueNode*> tail_{nullptr};
+    // Written by the owner after acquiring and read by it to release, so the lock orders it.
+    QueueNode* holder_{nullptr};
+    QueueNode overflow_node_{.shared = true};
+};
+
+// Guards any lock with lock()/unlock(); deduces the lock type from the constructor argument.
+template <typename Lock> class [[nodiscard]] SpinlockGuard {
   public:
-    explicit SpinlockGuard(Spinlock& lock) noexcept : lock_(lock) {
+    explicit SpinlockGuard(Lock& lock) noexcept : lock_(lock) {
         lock_.lock();
     }
 
+    // Takes over a lock the caller already holds, e.g. after a successful try_lock().
+    SpinlockGuard(Lock& lock, std::adopt_lock_t) noexcept : lock_(lock) {}
+
     ~SpinlockGuard() noexcept {
         lock_.unlock();
     }
@@ -74,5 +254,5 @@ class [[nodiscard]] SpinlockGuard {
     SpinlockGuard& operator=(const SpinlockGuard&) = delete;
 
   private:
-    Spinlock& lock_;
+    Lock& lock_;
 };
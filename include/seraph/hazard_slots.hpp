@@ -0,0 +1,146 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <thread>
+
+namespace seraph {
+
+    // Hazard-pointer records for containers whose threads protect at most two Pointee objects at
+    // a time. Every container with the same Pointee type shares one static array of records; a
+    // thread claims a record per slot on first use and gives it back when it exits. Scans stop at
+    // the highest record ever claimed, so a process with few threads reads few records.
+    template <typename Pointee> class hazard_slots {
+      private:
+#if defined(__cpp_lib_hardware_interference_size)
+        static constexpr size_t k_destructive_interference_size{
+                std::hardware_destructive_interference_size
+        };
+#else
+        static constexpr size_t k_destructive_interference_size{64};
+#endif
+
+      public:
+        static constexpr size_t k_max_records{64};
+        static constexpr size_t k_local_slots{2};
+
+        struct alignas(k_destructive_interference_size) record {
+            std::atomic<std::thread::id> owner;
+            std::atomic<Pointee*> pointer;
+        };
+
+        // Returns the calling thread's record for `slot`, claiming a free one on first use.
+        // Terminates if every record is owned by another thread.
+        static auto acquire(size_t slot) -> record* {
+            record* hazard(local_records_[slot]);
+
+            if (hazard) [[likely]] {
+                return hazard;
+            }
+
+            for (size_t iii{0}; iii < k_max_records; ++iii) {
+                std::thread::id empty;
+
+                if (records_[iii].owner.compare_exchange_strong(
+                            empty,
+                            std::this_thread::get_id(),
+                            std::memory_order_acq_rel
+                    )) {
+                    (void)releaser_;
+                    size_t high_water(high_water_.load(std::memory_order_relaxed));
+
+                    while (high_water < iii + 1 &&
+                           !high_water_.compare_exchange_weak(
+                                   high_water,
+                                   iii + 1,
+                                   std::memory_order_seq_cst,
+                                   std::memory_order_relaxed
+                           )) {}
+
+                    local_records_[slot] = &records_[iii];
+                    return local_records_[slot];
+                }
+            }
+
+            std::terminate();
+        }
+
+        static void clear_local() noexcept {
+            for (record* hazard : local_records_) {
+                if (hazard) {
+                    hazard->pointer.store(nullptr, std::memory_order_release);
+                }
+            }
+        }
+
+        // Clears the calling thread's hazards every k_clear_interval calls, or now if `force`.
+        static void maybe_clear_local(bool force = false) noexcept {
+            if (!force) {
+                ++ops_since_clear_;
+                if (ops_since_clear_ < k_clear_interval) {
+                    return;
+                }
+            }
+
+            clear_local();
+            ops_since_clear_ = 0;
+        }
+
+        // Copies every published hazard into `snapshot` and returns how many there are.
+        static auto snapshot(std::array<Pointee*, k_max_records>& snapshot) noexcept -> size_t {
+            size_t active_hazards{0};
+            const size_t record_count(high_water_.load(std::memory_order_seq_cst));
+
+            for (size_t iii{0}; iii < record_count; ++iii) {
+                Pointee* hazard_ptr(records_[iii].pointer.load(std::memory_order_seq_cst));
+
+                if (hazard_ptr) {
+                    snapshot[active_hazards++] = hazard_ptr;
+                }
+            }
+
+            return active_hazards;
+        }
+
+      private:
+        static constexpr size_t k_clear_interval{64};
+
+        struct Releaser {
+            ~Releaser() {
+                for (record*& hazard : local_records_) {
+                    if (!hazard) {
+                        continue;
+                    }
+
+                    hazard->pointer.store(nullptr, std::memory_order_release);
+                    hazard->owner.store(std::thread::id{}, std::memory_order_release);
+                    hazard = nullptr;
+                }
+            }
+        };
+
+        static record records_[k_max_records];
+        // One past the highest record ever claimed; scans stop there.
+        static std::atomic<size_t> high_water_;
+        static thread_local std::array<record*, k_local_slots> local_records_;
+        static thread_local Releaser releaser_;
+        static thread_local size_t ops_since_clear_;
+    };
+
+    template <typename Pointee>
+    typename hazard_slots<Pointee>::record
+            hazard_slots<Pointee>::records_[hazard_slots<Pointee>::k_max_records];
+    template <typename Pointee> std::atomic<size_t> hazard_slots<Pointee>::high_water_{0};
+    template <typename Pointee>
+    thread_local std::array<
+            typename hazard_slots<Pointee>::record*,
+            hazard_slots<Pointee>::k_local_slots>
+            hazard_slots<Pointee>::local_records_{};
+    template <typename Pointee>
+    thread_local typename hazard_slots<Pointee>::Releaser hazard_slots<Pointee>::releaser_;
+    template <typename Pointee> thread_local size_t hazard_slots<Pointee>::ops_since_clear_{0};
+
+} // namespace seraph
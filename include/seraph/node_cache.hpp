@@ -0,0 +1,209 @@
+#pragma once
+
+#include "locks.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+namespace seraph {
+
+    // Recycles storage for nodes of one size and alignment. Reclaimed nodes are destroyed in
+    // place by their container and their storage is kept on a per-thread free list that new nodes
+    // draw from. Full batches move through a bounded shared depot, so a thread that mostly
+    // reclaims hands storage to a thread that mostly allocates; storage beyond the depot's
+    // capacity goes back to the allocator. Containers whose nodes have the same layout share one
+    // cache.
+    template <size_t Size, size_t Alignment> class node_cache {
+      public:
+        // Process-wide reuse counters. A hit reuses reclaimed storage; a miss goes to the global
+        // allocator.
+        struct stats {
+            size_t hits;
+            size_t misses;
+        };
+
+        static void* take() {
+            Cache& cache(cache_);
+
+            if (cache.head || refill_from_depot(cache)) {
+                void* storage(cache.head);
+                cache.head = cache.head->next;
+                --cache.count;
+                ++cache.hits;
+                return storage;
+            }
+
+            void* storage(allocate());
+            ++cache.misses;
+            return storage;
+        }
+
+        static void recycle(void* storage) noexcept {
+            Cache& cache(cache_);
+            FreeNode* free_node(::new (storage) FreeNode{cache.head});
+
+            cache.head = free_node;
+            ++cache.count;
+
+            if (cache.count > k_capacity) {
+                spill_batch(cache);
+            }
+        }
+
+        // Storage that bypasses the free lists, for nodes kept in a pool of their own.
+        static void* allocate() {
+            if constexpr (Alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+                return ::operator new(Size, std::align_val_t{Alignment});
+            }
+            else {
+                return ::operator new(Size);
+            }
+        }
+
+        static void deallocate(void* storage) noexcept {
+            if constexpr (Alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+                ::operator delete(storage, std::align_val_t{Alignment});
+            }
+            else {
+                ::operator delete(storage);
+            }
+        }
+
+        // Lets a pool of its own report into the same counters.
+        static void count_hit() noexcept {
+            ++cache_.hits;
+        }
+
+        static void count_miss() noexcept {
+            ++cache_.misses;
+        }
+
+        // Counters from exited threads plus the calling thread's unflushed counts.
+        static stats get_stats() noexcept {
+            const Cache& cache(cache_);
+
+            return stats{
+                    .hits = depot_.hits.load(std::memory_order_relaxed) + cache.hits,
+                    .misses = depot_.misses.load(std::memory_order_relaxed) + cache.misses,
+            };
+        }
+
+      private:
+        static constexpr size_t k_batch{64};
+        static constexpr size_t k_capacity{2 * k_batch};
+        static constexpr size_t k_depot_capacity{64};
+
+        struct FreeNode {
+            FreeNode* next;
+        };
+
+        static_assert(Size >= sizeof(FreeNode));
+        static_assert(Alignment >= alignof(FreeNode));
+
+        // A fixed array, so handing a batch over never allocates.
+        struct Depot {
+            Spinlock lock;
+            std::array<FreeNode*, k_depot_capacity> batches{};
+            size_t batch_count{0};
+            std::atomic<size_t> hits{0};
+            std::atomic<size_t> misses{0};
+
+            ~Depot() {
+                for (size_t iii{0}; iii < batch_count; ++iii) {
+                    free_chain(batches[iii]);
+                }
+            }
+        };
+
+        struct Cache {
+            FreeNode* head{nullptr};
+            size_t count{0};
+            size_t hits{0};
+            size_t misses{0};
+
+            void flush_stats() noexcept {
+                depot_.hits.fetch_add(hits, std::memory_order_relaxed);
+                depot_.misses.fetch_add(misses, std::memory_order_relaxed);
+                hits = 0;
+                misses = 0;
+            }
+
+            ~Cache() {
+                flush_stats();
+
+                while (count >= k_batch) {
+                    spill_batch(*this);
+                }
+
+                free_chain(head);
+                head = nullptr;
+                count = 0;
+            }
+        };
+
+        static void free_chain(FreeNode* chain) noexcept {
+            while (chain) {
+                FreeNode* next(chain->next);
+                deallocate(chain);
+                chain = next;
+            }
+        }
+
+        // Moves one batch from the front of the local free list to the depot.
+        static void spill_batch(Cache& cache) noexcept {
+            FreeNode* batch(cache.head);
+            FreeNode* batch_tail(batch);
+
+            for (size_t iii{1}; iii < k_batch; ++iii) {
+                batch_tail = batch_tail->next;
+            }
+
+            cache.head = batch_tail->next;
+            cache.count -= k_batch;
+            batch_tail->next = nullptr;
+
+            {
+                SpinlockGuard guard(depot_.lock);
+
+                if (depot_.batch_count < k_depot_capacity) {
+                    depot_.batches[depot_.batch_count++] = batch;
+                    batch = nullptr;
+                }
+            }
+
+            free_chain(batch);
+            cache.flush_stats();
+        }
+
+        static bool refill_from_depot(Cache& cache) noexcept {
+            FreeNode* batch{nullptr};
+            {
+                SpinlockGuard guard(depot_.lock);
+
+                if (depot_.batch_count != 0) {
+                    batch = depot_.batches[--depot_.batch_count];
+                }
+            }
+
+            if (!batch) {
+                return false;
+            }
+
+            cache.head = batch;
+            cache.count = k_batch;
+            cache.flush_stats();
+            return true;
+        }
+
+        static Depot depot_;
+        static thread_local Cache cache_;
+    };
+
+    template <size_t Size, size_t Alignment>
+    typename node_cache<Size, Alignment>::Depot node_cache<Size, Alignment>::depot_;
+    template <size_t Size, size_t Alignment>
+    thread_local typename node_cache<Size, Alignment>::Cache node_cache<Size, Alignment>::cache_;
+
+} // namespace seraph
@@ -1,12 +1,16 @@
 #pragma once
 
+#include "seraph/hazard_slots.hpp"
+#include "seraph/node_cache.hpp"
+
 #include <array>
 #include <atomic>
 #include <cstddef>
-#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
 #include <new>
 #include <optional>
-#include <thread>
 #include <utility>
 #include <vector>
 
@@ -14,14 +18,6 @@ namespace seraph {
 
     template <typename T> class queue {
       private:
-#if defined(__cpp_lib_hardware_interference_size)
-        static constexpr size_t k_destructive_interference_size{
-                std::hardware_destructive_interference_size
-        };
-#else
-        static constexpr size_t k_destructive_interference_size{64};
-#endif
-
         struct Node {
             std::atomic<Node*> next;
             std::optional<T> value;
@@ -33,80 +29,33 @@ namespace seraph {
                 : next(nullptr), value(std::in_place, std::forward<Args>(args)...) {}
         };
 
-        struct alignas(k_destructive_interference_size) HazardRecord {
-            std::atomic<std::thread::id> owner;
-            std::atomic<Node*> pointer;
-        };
-
-        struct HazardReleaser {
-            ~HazardReleaser() {
-                for (HazardRecord*& hazard : local_hazards_) {
-                    if (!hazard) {
-                        continue;
-                    }
-
-                    hazard->pointer.store(nullptr, std::memory_order_release);
-                    hazard->owner.store(std::thread::id{}, std::memory_order_release);
-                    hazard = nullptr;
-                }
-            }
-        };
-
-        static constexpr size_t k_max_hazard_pointers{32};
-        static constexpr size_t k_local_hazard_slots{2};
-        static constexpr size_t k_hazard_clear_interval{64};
         static constexpr size_t k_retire_scan_threshold{256};
         static constexpr size_t k_retire_scan_budget{16};
 
-        static HazardRecord hazard_records_[k_max_hazard_pointers];
-        static thread_local std::array<HazardRecord*, k_local_hazard_slots> local_hazards_;
-        static thread_local HazardReleaser hazard_releaser_;
-        static thread_local size_t hazard_ops_since_clear_;
-        static thread_local std::vector<Node*> retire_list_;
-
-        static auto acquire_hazard(size_t slot) -> HazardRecord* {
-            HazardRecord* hazard(local_hazards_[slot]);
+        // Reclaimed nodes are destroyed in place and their storage goes back to the node cache,
+        // which emplace() draws from.
+        using NodeStorage = node_cache<sizeof(Node), alignof(Node)>;
+        // Two hazards per thread: the head (or tail) and the node after it.
+        using Hazards = hazard_slots<Node>;
+        using HazardRecord = typename Hazards::record;
 
-            if (hazard) {
-                return hazard;
-            }
-
-            for (size_t iii{0}; iii < k_max_hazard_pointers; ++iii) {
-                std::thread::id empty;
+        static thread_local std::vector<Node*> retire_list_;
 
-                if (hazard_records_[iii].owner.compare_exchange_strong(
-                            empty,
-                            std::this_thread::get_id(),
-                            std::memory_order_acq_rel
-                    )) {
-                    (void)hazard_releaser_;
-                    local_hazards_[slot] = &hazard_records_[iii];
+        template <typename... Args> static Node* create_node(Args&&... args) {
+            void* storage(NodeStorage::take());
 
-                    return local_hazards_[slot];
-                }
+            try {
+                return ::new (storage) Node(std::forward<Args>(args)...);
             }
-
-            std::terminate();
-        }
-
-        static void clear_local_hazard_pointers() {
-            for (HazardRecord* hazard : local_hazards_) {
-                if (hazard) {
-                    hazard->pointer.store(nullptr, std::memory_order_release);
-                }
+            catch (...) {
+                NodeStorage::recycle(storage);
+                throw;
             }
         }
 
-        static void maybe_clear_local_hazard_pointers(bool force = false) {
-            if (!force) {
-                ++hazard_ops_since_clear_;
-                if (hazard_ops_since_clear_ < k_hazard_clear_interval) {
-                    return;
-                }
-            }
-
-            clear_local_hazard_pointers();
-            hazard_ops_since_clear_ = 0;
+        static void destroy_node(Node* node) noexcept {
+            std::destroy_at(node);
+            NodeStorage::recycle(node);
         }
 
         static void scan_incremental(size_t scan_budget) {
@@ -114,16 +63,8 @@ namespace seraph {
                 return;
             }
 
-            std::array<Node*, k_max_hazard_pointers> hazard_snapshot{};
-            size_t active_hazards{0};
-
-            for (size_t iii{0}; iii < k_max_hazard_pointers; ++iii) {
-                Node* hazard_ptr(hazard_records_[iii].pointer.load(std::memory_order_acquire));
-
-                if (hazard_ptr) {
-                    hazard_snapshot[active_hazards++] = hazard_ptr;
-                }
-            }
+            std::array<Node*, Hazards::k_max_records> hazard_snapshot{};
+            const size_t active_hazards(Hazards::snapshot(hazard_snapshot));
 
             if (active_hazards == 0) {
                 const size_t reclaim_count(
@@ -131,7 +72,7 @@ namespace seraph {
                 );
 
                 for (size_t iii{0}; iii < reclaim_count; ++iii) {
-                    delete retire_list_.back();
+                    destroy_node(retire_list_.back());
                     retire_list_.pop_back();
                 }
 
@@ -157,7 +98,7 @@ namespace seraph {
                     ++read_index;
                 }
                 else {
-                    delete retired_node;
+                    destroy_node(retired_node);
                     retire_list_[read_index] = retire_list_.back();
                     retire_list_.pop_back();
                 }
@@ -181,7 +122,7 @@ namespace seraph {
 
             while (node) {
                 Node* next(node->next.load(std::memory_order_relaxed));
-                delete node;
+                destroy_node(node);
                 node = next;
             }
 
@@ -192,49 +133,17 @@ namespace seraph {
 
         static void clear_local_retired_nodes() noexcept {
             for (Node* node : retire_list_) {
-                delete node;
+                destroy_node(node);
             }
 
             retire_list_.clear();
         }
 
-        std::atomic<Node*> head_{nullptr};
-        std::atomic<Node*> tail_{nullptr};
-        std::atomic<size_t> size_{0};
-
-      public:
-        queue() {
-            Node* dummy(new Node());
-            head_.store(dummy, std::memory_order_relaxed);
-            tail_.store(dummy, std::memory_order_relaxed);
-        }
-
-        ~queue() {
-            clear_local_hazard_pointers();
-            clear_live_nodes();
-            clear_local_retired_nodes();
-        }
-
-        queue(const queue&) = delete;
-        auto operator=(const queue&) -> queue& = delete;
-
-        void push(const T& value) {
-            emplace(value);
-        }
-
-        void push(T&& value) {
-            emplace(std::move(value));
-        }
-
-        template <typename InputIt> void push_range(InputIt first, InputIt last) {
-            for (; first != last; ++first) {
-                emplace(*first);
-            }
-        }
-
-        template <typename... Args> void emplace(Args&&... args) {
-            Node* new_node(new Node(std::forward<Args>(args)...));
-            HazardRecord* hazard_tail(acquire_hazard(0));
+        // Appends the privately linked chain first..last. Helpers may move the tail through the
+        // chain one node at a time; the final swing then fails and the tail lags until the next
+        // operation advances it.
+        void append_chain(Node* first, Node* last, size_t count) {
+            HazardRecord* hazard_tail(Hazards::acquire(0));
 
             while (true) {
                 Node* tail(tail_.load(std::memory_order_acquire));
@@ -255,18 +164,18 @@ namespace seraph {
 
                     if (tail->next.compare_exchange_weak(
                                 expected,
-                                new_node,
+                                first,
                                 std::memory_order_release,
                                 std::memory_order_relaxed
                         )) {
                         tail_.compare_exchange_strong(
                                 tail,
-                                new_node,
+                                last,
                                 std::memory_order_release,
                                 std::memory_order_relaxed
                         );
-                        size_.fetch_add(1, std::memory_order_relaxed);
-                        maybe_clear_local_hazard_pointers();
+                        size_.fetch_add(count, std::memory_order_relaxed);
+                        Hazards::maybe_clear_local();
                         return;
                     }
                 }
@@ -281,9 +190,215 @@ namespace seraph {
             }
         }
 
+        // Claims up to `n` values with one head_ advance. The values sit in the nodes after
+        // `first` up to and including `last`. `last` stays in the queue as the new dummy; every
+        // node before it now belongs to the caller. Returns the number of values claimed.
+        auto claim_run(size_t n, Node*& first, Node*& last) -> size_t {
+            HazardRecord* hazard_head(Hazards::acquire(0));
+            HazardRecord* hazard_node(Hazards::acquire(1));
+
+            while (true) {
+                Node* head(head_.load(std::memory_order_acquire));
+                hazard_head->pointer.store(head, std::memory_order_release);
+
+                if (head != head_.load(std::memory_order_acquire)) {
+                    continue;
+                }
+
+                // While head_ still equals the protected head, no node behind it has been
+                // retired, so each step protects the next node and re-checks head_.
+                Node* tail(tail_.load(std::memory_order_acquire));
+                Node* current(head);
+                size_t count{0};
+                bool moved{false};
+
+                while (count < n) {
+                    Node* next(current->next.load(std::memory_order_acquire));
+
+                    if (next == nullptr) {
+                        break;
+                    }
+
+                    hazard_node->pointer.store(next, std::memory_order_release);
+
+                    if (head != head_.load(std::memory_order_acquire)) {
+                        moved = true;
+                        break;
+                    }
+
+                    // The head must not pass the tail, so a tail lagging inside the run is moved
+                    // along with the walk. `tail` follows it on success; on failure it is reloaded
+                    // and is already further on.
+                    if (current == tail) {
+                        if (tail_.compare_exchange_strong(
+                                    tail,
+                                    next,
+                                    std::memory_order_release,
+                                    std::memory_order_acquire
+                            )) {
+                            tail = next;
+                        }
+                    }
+
+                    current = next;
+                    ++count;
+                }
+
+                if (moved) {
+                    continue;
+                }
+
+                if (count == 0) {
+                    Hazards::maybe_clear_local();
+                    return 0;
+                }
+
+                if (head_.compare_exchange_strong(
+                            head,
+                            current,
+                            std::memory_order_acq_rel,
+                            std::memory_order_acquire
+                    )) {
+                    size_.fetch_sub(count, std::memory_order_relaxed);
+                    first = head;
+                    last = current;
+                    return count;
+                }
+            }
+        }
+
+        // Claims up to `n` values and passes each one to `sink` as an rvalue, oldest first, with
+        // no synchronization per value. If `sink` throws, the values it has not consumed are
+        // appended back at the tail in their original order and the exception propagates.
+        template <typename Sink> auto take_run(size_t n, Sink& sink) -> size_t {
+            Node* first{nullptr};
+            Node* last{nullptr};
+            const size_t count(claim_run(n, first, last));
+
+            if (count == 0) {
+                return 0;
+            }
+
+            // `last` is still reachable, so its value is taken before the hazards are dropped;
+            // the nodes in between are private to this thread.
+            T last_value(std::move(*(last->value)));
+            Node* node(first->next.load(std::memory_order_relaxed));
+
+            Hazards::clear_local();
+            retire_node(first);
+
+            try {
+                while (node != last) {
+                    Node* next(node->next.load(std::memory_order_relaxed));
+                    sink(std::move(*(node->value)));
+                    retire_node(node);
+                    node = next;
+                }
+
+                sink(std::move(last_value));
+            }
+            catch (...) {
+                Node* chain_head{nullptr};
+                Node* chain_tail{nullptr};
+                size_t remaining{0};
+
+                auto relink = [&](T&& value) {
+                    Node* relinked(create_node(std::move(value)));
+
+                    if (chain_tail) {
+                        chain_tail->next.store(relinked, std::memory_order_relaxed);
+                    }
+                    else {
+                        chain_head = relinked;
+                    }
+
+                    chain_tail = relinked;
+                    ++remaining;
+                };
+
+                while (node != last) {
+                    Node* next(node->next.load(std::memory_order_relaxed));
+                    relink(std::move(*(node->value)));
+                    retire_node(node);
+                    node = next;
+                }
+
+                relink(std::move(last_value));
+                append_chain(chain_head, chain_tail, remaining);
+                throw;
+            }
+
+            return count;
+        }
+
+        std::atomic<Node*> head_{nullptr};
+        // Mutable so that back() can help a lagging tail forward.
+        mutable std::atomic<Node*> tail_{nullptr};
+        std::atomic<size_t> size_{0};
+
+      public:
+        queue() {
+            Node* dummy(create_node());
+            head_.store(dummy, std::memory_order_relaxed);
+            tail_.store(dummy, std::memory_order_relaxed);
+        }
+
+        ~queue() {
+            Hazards::clear_local();
+            clear_live_nodes();
+            clear_local_retired_nodes();
+        }
+
+        queue(const queue&) = delete;
+        auto operator=(const queue&) -> queue& = delete;
+
+        void push(const T& value) {
+            emplace(value);
+        }
+
+        void push(T&& value) {
+            emplace(std::move(value));
+        }
+
+        // Links the values privately and appends the whole run with one CAS on tail->next, so
+        // the batch becomes visible to consumers at once, in order.
+        template <typename InputIt> void push_range(InputIt first, InputIt last) {
+            if (first == last) {
+                return;
+            }
+
+            Node* batch_head(create_node(*first));
+            Node* batch_tail(batch_head);
+            size_t count{1};
+
+            try {
+                for (++first; first != last; ++first) {
+                    Node* node(create_node(*first));
+                    batch_tail->next.store(node, std::memory_order_relaxed);
+                    batch_tail = node;
+                    ++count;
+                }
+            }
+            catch (...) {
+                while (batch_head) {
+                    Node* next(batch_head->next.load(std::memory_order_relaxed));
+                    destroy_node(batch_head);
+                    batch_head = next;
+                }
+                throw;
+            }
+
+            append_chain(batch_head, batch_tail, count);
+        }
+
+        template <typename... Args> void emplace(Args&&... args) {
+            Node* new_node(create_node(std::forward<Args>(args)...));
+            append_chain(new_node, new_node, 1);
+        }
+
         [[nodiscard]] auto pop() -> std::optional<T> {
-            HazardRecord* hazard_head(acquire_hazard(0));
-            HazardRecord* hazard_next(acquire_hazard(1));
+            HazardRecord* hazard_head(Hazards::acquire(0));
+            HazardRecord* hazard_next(Hazards::acquire(1));
 
             while (true) {
                 Node* head(head_.load(std::memory_order_acquire));
@@ -301,7 +416,7 @@ namespace seraph {
                 }
 
                 if (next == nullptr) {
-                    maybe_clear_local_hazard_pointers();
+                    Hazards::maybe_clear_local();
                     return std::nullopt;
                 }
 
@@ -324,7 +439,7 @@ namespace seraph {
                     )) {
                     size_.fetch_sub(1, std::memory_order_relaxed);
                     std::optional<T> result(std::move(*(next->value)));
-                    maybe_clear_local_hazard_pointers();
+                    Hazards::maybe_clear_local();
 
                     retire_node(head);
 
@@ -333,9 +448,35 @@ namespace seraph {
             }
         }
 
+        // Pops up to `n` values as one operation and writes them to `out` in FIFO order. Returns
+        // the number of values written.
+        template <typename OutputIt> auto pop_n(size_t n, OutputIt out) -> size_t {
+            if (n == 0) {
+                return 0;
+            }
+
+            auto sink = [&out](T&& value) {
+                *out = std::move(value);
+                ++out;
+            };
+
+            return take_run(n, sink);
+        }
+
+        // Takes every value with one head_ advance and passes each one to `visitor` as an
+        // rvalue, oldest first. Returns the number of values visited. If the visitor throws, the
+        // values not yet consumed are appended back behind whatever was pushed in the meantime.
+        template <typename F> auto drain(F&& visitor) -> size_t {
+            auto sink = [&visitor](T&& value) {
+                std::invoke(visitor, std::move(value));
+            };
+
+            return take_run(std::numeric_limits<size_t>::max(), sink);
+        }
+
         [[nodiscard]] auto front() const -> std::optional<T> {
-            HazardRecord* hazard_head(acquire_hazard(0));
-            HazardRecord* hazard_next(acquire_hazard(1));
+            HazardRecord* hazard_head(Hazards::acquire(0));
+            HazardRecord* hazard_next(Hazards::acquire(1));
 
             while (true) {
                 Node* head(head_.load(std::memory_order_acquire));
@@ -353,63 +494,73 @@ namespace seraph {
                 }
 
                 if (next == nullptr) {
-                    maybe_clear_local_hazard_pointers();
+                    Hazards::maybe_clear_local();
                     return std::nullopt;
                 }
 
                 std::optional<T> result(*(next->value));
-                maybe_clear_local_hazard_pointers();
+                Hazards::maybe_clear_local();
                 return result;
             }
         }
 
+        // Reads the last value in constant time. The head is re-read after the protected tail is
+        // found to have no successor; an unchanged head means both were current at that instant,
+        // and the queue was empty there if they were the same node.
         [[nodiscard]] auto back() const -> std::optional<T> {
-            HazardRecord* hazard_curr(acquire_hazard(0));
-            HazardRecord* hazard_next(acquire_hazard(1));
+            HazardRecord* hazard_head(Hazards::acquire(0));
+            HazardRecord* hazard_tail(Hazards::acquire(1));
 
             while (true) {
                 Node* head(head_.load(std::memory_order_acquire));
-                hazard_curr->pointer.store(head, std::memory_order_release);
+                hazard_head->pointer.store(head, std::memory_order_release);
 
                 if (head != head_.load(std::memory_order_acquire)) {
                     continue;
                 }
 
-                Node* current(head->next.load(std::memory_order_acquire));
-                hazard_next->pointer.store(current, std::memory_order_release);
+                Node* tail(tail_.load(std::memory_order_acquire));
+                hazard_tail->pointer.store(tail, std::memory_order_release);
 
-                if (head != head_.load(std::memory_order_acquire)) {
+                if (tail != tail_.load(std::memory_order_acquire)) {
                     continue;
                 }
 
-                if (current == nullptr) {
-                    maybe_clear_local_hazard_pointers();
-                    return std::nullopt;
-                }
+                Node* next(tail->next.load(std::memory_order_acquire));
 
-                hazard_curr->pointer.store(current, std::memory_order_release);
-                hazard_next->pointer.store(nullptr, std::memory_order_release);
+                if (next != nullptr) {
+                    tail_.compare_exchange_weak(
+                            tail,
+                            next,
+                            std::memory_order_release,
+                            std::memory_order_relaxed
+                    );
+                    continue;
+                }
 
-                while (true) {
-                    Node* next(current->next.load(std::memory_order_acquire));
+                if (head != head_.load(std::memory_order_acquire)) {
+                    continue;
+                }
 
-                    if (next == nullptr) {
-                        std::optional<T> result(*(current->value));
-                        maybe_clear_local_hazard_pointers();
-                        return result;
-                    }
+                if (head == tail) {
+                    Hazards::maybe_clear_local();
+                    return std::nullopt;
+                }
 
-                    hazard_next->pointer.store(next, std::memory_order_release);
+                std::optional<T> result(*(tail->value));
+                Hazards::maybe_clear_local();
+                return result;
+            }
+        }
 
-                    if (current->next.load(std::memory_order_acquire) != next) {
-                        continue;
-                    }
+        // Process-wide reuse counters of the node cache, which is shared with every container
+        // whose nodes have the same size and alignment. A hit reuses reclaimed storage; a miss
+        // goes to the global allocator.
+        using cache_stats = typename NodeStorage::stats;
 
-                    current = next;
-                    hazard_curr->pointer.store(current, std::memory_order_release);
-                    hazard_next->pointer.store(nullptr, std::memory_order_release);
-                }
-            }
+        // Counters from exited threads plus the calling thread's unflushed counts.
+        static auto node_cache_stats() noexcept -> cache_stats {
+            return NodeStorage::get_stats();
         }
 
         [[nodiscard]] auto empty() const noexcept -> bool {
@@ -421,13 +572,6 @@ namespace seraph {
         }
     };
 
-    template <typename T>
-    typename queue<T>::HazardRecord queue<T>::hazard_records_[queue<T>::k_max_hazard_pointers];
-    template <typename T>
-    thread_local std::array<typename queue<T>::HazardRecord*, queue<T>::k_local_hazard_slots>
-            queue<T>::local_hazards_{};
-    template <typename T> thread_local typename queue<T>::HazardReleaser queue<T>::hazard_releaser_;
-    template <typename T> thread_local size_t queue<T>::hazard_ops_since_clear_{0};
     template <typename T> thread_local std::vector<typename queue<T>::Node*> queue<T>::retire_list_;
 
 } // namespace seraph
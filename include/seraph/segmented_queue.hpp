@@ -0,0 +1,448 @@
+#pragma once
+
+#include "locks.hpp"
+#include "seraph/hazard_slots.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace seraph {
+
+    // Unbounded MPMC FIFO queue built from linked array segments. Producers and consumers claim
+    // a cell with one fetch_add on the segment's enqueue or dequeue index, so under contention
+    // they spread over different cells instead of retrying a CAS on the same pointer. Only the
+    // thread that fills a segment appends the next one. Whole segments are retired once every
+    // consumer has moved past them and are freed through hazard pointers.
+    template <typename T, size_t SegmentSize = 1024> class segmented_queue {
+        static_assert(SegmentSize > 0, "a segment needs at least one cell");
+
+      private:
+#if defined(__cpp_lib_hardware_interference_size)
+        static constexpr size_t k_destructive_interference_size{
+                std::hardware_destructive_interference_size
+        };
+#else
+        static constexpr size_t k_destructive_interference_size{64};
+#endif
+
+        // A cell is written once by the producer that claimed its index and read once by the
+        // consumer that claimed it. A consumer that arrives first marks the cell taken; the
+        // producer then fails to publish and claims another index.
+        static constexpr uint32_t k_cell_empty{0};
+        static constexpr uint32_t k_cell_full{1};
+        static constexpr uint32_t k_cell_taken{2};
+
+        // Spins a consumer waits for a producer that already claimed its cell before abandoning
+        // the cell and forcing the producer to retry.
+        static constexpr size_t k_take_spin{32};
+
+        struct Cell {
+            std::atomic<uint32_t> state{k_cell_empty};
+            alignas(T) unsigned char storage[sizeof(T)];
+
+            auto value() noexcept -> T* {
+                return std::launder(reinterpret_cast<T*>(storage));
+            }
+        };
+
+        struct Segment {
+            alignas(k_destructive_interference_size) std::atomic<size_t> enqueue_index{0};
+            alignas(k_destructive_interference_size) std::atomic<size_t> dequeue_index{0};
+            alignas(k_destructive_interference_size) std::atomic<Segment*> next{nullptr};
+            const size_t id;
+            std::array<Cell, SegmentSize> cells;
+
+            explicit Segment(size_t segment_id) : id(segment_id) {}
+
+            // Only called once no other thread can reach the segment.
+            ~Segment() {
+                for (Cell& cell : cells) {
+                    if (cell.state.load(std::memory_order_relaxed) == k_cell_full) {
+                        std::destroy_at(cell.value());
+                    }
+                }
+            }
+        };
+
+        // Segments retired by exited threads that were still protected when the thread left.
+        // The next thread to scan adopts them; whatever is left at process exit is freed here.
+        struct OrphanList {
+            Spinlock lock;
+            std::vector<Segment*> segments;
+            std::atomic<bool> pending{false};
+
+            ~OrphanList() {
+                for (Segment* segment : segments) {
+                    delete segment;
+                }
+            }
+        };
+
+        // Segments retired by this thread.
+        struct RetireList {
+            std::vector<Segment*> segments;
+
+            ~RetireList() {
+                scan_retired(segments.size());
+
+                if (segments.empty()) {
+                    return;
+                }
+
+                SpinlockGuard guard(orphans_.lock);
+                orphans_.segments.insert(
+                        orphans_.segments.end(),
+                        segments.begin(),
+                        segments.end()
+                );
+                orphans_.pending.store(true, std::memory_order_release);
+                segments.clear();
+            }
+        };
+
+        static constexpr size_t k_retire_scan_threshold{8};
+
+        // Two hazards per thread: the head segment and, for size(), the tail segment.
+        using Hazards = hazard_slots<Segment>;
+        using HazardRecord = typename Hazards::record;
+
+        static OrphanList orphans_;
+        static thread_local RetireList retire_list_;
+
+        // Publishes `source` in `hazard` and returns the segment it protects.
+        static auto protect(const std::atomic<Segment*>& source, HazardRecord* hazard)
+                -> Segment* {
+            Segment* segment(source.load(std::memory_order_acquire));
+
+            while (true) {
+                hazard->pointer.store(segment, std::memory_order_seq_cst);
+                Segment* current(source.load(std::memory_order_acquire));
+
+                if (current == segment) [[likely]] {
+                    return segment;
+                }
+
+                segment = current;
+            }
+        }
+
+        static void adopt_orphans(std::vector<Segment*>& retired) {
+            SpinlockGuard guard(orphans_.lock);
+
+            retired.insert(retired.end(), orphans_.segments.begin(), orphans_.segments.end());
+            orphans_.segments.clear();
+            orphans_.pending.store(false, std::memory_order_relaxed);
+        }
+
+        static void scan_retired(size_t scan_budget) {
+            std::vector<Segment*>& retired(retire_list_.segments);
+
+            if (orphans_.pending.load(std::memory_order_acquire)) [[unlikely]] {
+                adopt_orphans(retired);
+                scan_budget = retired.size();
+            }
+
+            if (retired.empty() || scan_budget == 0) {
+                return;
+            }
+
+            std::array<Segment*, Hazards::k_max_records> hazard_snapshot{};
+            const size_t active_hazards(Hazards::snapshot(hazard_snapshot));
+
+            size_t inspected{0};
+            size_t read_index{0};
+
+            while (inspected < scan_budget && read_index < retired.size()) {
+                Segment* retired_segment(retired[read_index]);
+                bool keep_segment{false};
+
+                for (size_t iii{0}; iii < active_hazards; ++iii) {
+                    if (hazard_snapshot[iii] == retired_segment) {
+                        keep_segment = true;
+                        break;
+                    }
+                }
+                ++inspected;
+
+                if (keep_segment) {
+                    ++read_index;
+                }
+                else {
+                    delete retired_segment;
+                    retired[read_index] = retired.back();
+                    retired.pop_back();
+                }
+            }
+        }
+
+        static void retire_segment(Segment* segment) {
+            std::vector<Segment*>& retired(retire_list_.segments);
+            retired.push_back(segment);
+
+            if (retired.size() >= k_retire_scan_threshold) {
+                scan_retired(retired.size());
+            }
+        }
+
+        // Moves the value to enqueue from `spare` into `cell`. emplace() builds it in `spare`
+        // before claiming an index, so between the claim and the publish there is only this move
+        // for a waiting consumer to sit through.
+        static void construct_in(Cell& cell, std::optional<T>& spare) {
+            ::new (static_cast<void*>(cell.storage)) T(std::move(*spare));
+            spare.reset();
+        }
+
+        // Moves a value whose cell could not be published back out of the cell.
+        static void park(Cell& cell, std::optional<T>& spare) {
+            T* value(cell.value());
+            spare.emplace(std::move(*value));
+            std::destroy_at(value);
+        }
+
+        // Appends a segment whose first cell holds the value. Returns false if another producer
+        // appended first; the value is then back in `spare`.
+        auto append_segment(Segment* tail, std::optional<T>& spare) -> bool {
+            auto segment(std::make_unique<Segment>(tail->id + 1));
+            Cell& cell(segment->cells[0]);
+
+            construct_in(cell, spare);
+            cell.state.store(k_cell_full, std::memory_order_relaxed);
+            segment->enqueue_index.store(1, std::memory_order_relaxed);
+
+            Segment* expected{nullptr};
+            if (tail->next.compare_exchange_strong(
+                        expected,
+                        segment.get(),
+                        std::memory_order_release,
+                        std::memory_order_acquire
+                )) {
+                Segment* appended(segment.release());
+                tail_.compare_exchange_strong(
+                        tail,
+                        appended,
+                        std::memory_order_release,
+                        std::memory_order_relaxed
+                );
+                return true;
+            }
+
+            park(cell, spare);
+            cell.state.store(k_cell_empty, std::memory_order_relaxed);
+            tail_.compare_exchange_strong(
+                    tail,
+                    expected,
+                    std::memory_order_release,
+                    std::memory_order_relaxed
+            );
+            return false;
+        }
+
+        alignas(k_destructive_interference_size) std::atomic<Segment*> head_{nullptr};
+        alignas(k_destructive_interference_size) std::atomic<Segment*> tail_{nullptr};
+
+      public:
+        segmented_queue() {
+            Segment* segment(new Segment(0));
+            head_.store(segment, std::memory_order_relaxed);
+            tail_.store(segment, std::memory_order_relaxed);
+        }
+
+        ~segmented_queue() {
+            Hazards::clear_local();
+
+            Segment* segment(head_.load(std::memory_order_relaxed));
+            while (segment) {
+                Segment* next(segment->next.load(std::memory_order_relaxed));
+                delete segment;
+                segment = next;
+            }
+
+            scan_retired(retire_list_.segments.size());
+        }
+
+        segmented_queue(const segmented_queue&) = delete;
+        auto operator=(const segmented_queue&) -> segmented_queue& = delete;
+
+        void push(const T& value) {
+            emplace(value);
+        }
+
+        void push(T&& value) {
+            emplace(std::move(value));
+        }
+
+        template <typename InputIt> void push_range(InputIt first, InputIt last) {
+            for (; first != last; ++first) {
+                emplace(*first);
+            }
+        }
+
+        template <typename... Args> void emplace(Args&&... args) {
+            std::optional<T> spare(std::in_place, std::forward<Args>(args)...);
+            HazardRecord* hazard(Hazards::acquire(0));
+
+            while (true) {
+                Segment* tail(protect(tail_, hazard));
+                const size_t index(tail->enqueue_index.fetch_add(1, std::memory_order_acq_rel));
+
+                if (index >= SegmentSize) [[unlikely]] {
+                    Segment* next(tail->next.load(std::memory_order_acquire));
+
+                    if (next) {
+                        tail_.compare_exchange_strong(
+                                tail,
+                                next,
+                                std::memory_order_release,
+                                std::memory_order_relaxed
+                        );
+                        continue;
+                    }
+
+                    if (append_segment(tail, spare)) {
+                        break;
+                    }
+                    continue;
+                }
+
+                Cell& cell(tail->cells[index]);
+                construct_in(cell, spare);
+
+                uint32_t expected{k_cell_empty};
+                if (cell.state.compare_exchange_strong(
+                            expected,
+                            k_cell_full,
+                            std::memory_order_release,
+                            std::memory_order_relaxed
+                    )) [[likely]] {
+                    break;
+                }
+
+                // A consumer gave up on this cell before the value arrived.
+                park(cell, spare);
+            }
+
+            Hazards::maybe_clear_local();
+        }
+
+        [[nodiscard]] auto pop() -> std::optional<T> {
+            HazardRecord* hazard(Hazards::acquire(0));
+
+            while (true) {
+                Segment* head(protect(head_, hazard));
+
+                if (head->dequeue_index.load(std::memory_order_acquire) >=
+                            head->enqueue_index.load(std::memory_order_acquire) &&
+                    head->next.load(std::memory_order_acquire) == nullptr) {
+                    Hazards::maybe_clear_local();
+                    return std::nullopt;
+                }
+
+                const size_t index(head->dequeue_index.fetch_add(1, std::memory_order_acq_rel));
+
+                if (index >= SegmentSize) [[unlikely]] {
+                    Segment* next(head->next.load(std::memory_order_acquire));
+
+                    if (!next) {
+                        Hazards::maybe_clear_local();
+                        return std::nullopt;
+                    }
+
+                    // The tail must never point at a retired segment, so move it first.
+                    Segment* tail(head);
+                    tail_.compare_exchange_strong(
+                            tail,
+                            next,
+                            std::memory_order_release,
+                            std::memory_order_relaxed
+                    );
+
+                    if (head_.compare_exchange_strong(
+                                head,
+                                next,
+                                std::memory_order_acq_rel,
+                                std::memory_order_relaxed
+                        )) {
+                        hazard->pointer.store(nullptr, std::memory_order_release);
+                        retire_segment(head);
+                    }
+                    continue;
+                }
+
+                Cell& cell(head->cells[index]);
+
+                if (cell.state.load(std::memory_order_acquire) == k_cell_empty &&
+                    index < head->enqueue_index.load(std::memory_order_acquire)) {
+                    for (size_t spin{0}; spin < k_take_spin; ++spin) {
+                        cpu_relax();
+
+                        if (cell.state.load(std::memory_order_acquire) != k_cell_empty) {
+                            break;
+                        }
+                    }
+                }
+
+                if (cell.state.exchange(k_cell_taken, std::memory_order_acq_rel) == k_cell_full) {
+                    T* value(cell.value());
+                    std::optional<T> result(std::move(*value));
+                    std::destroy_at(value);
+                    Hazards::maybe_clear_local();
+                    return result;
+                }
+            }
+        }
+
+        // Exact while no other thread is using the queue, approximate otherwise: the head and
+        // tail positions are not read at the same instant.
+        [[nodiscard]] auto size() const -> size_t {
+            HazardRecord* hazard_head(Hazards::acquire(0));
+            HazardRecord* hazard_tail(Hazards::acquire(1));
+            Segment* head(protect(head_, hazard_head));
+            Segment* tail(protect(tail_, hazard_tail));
+
+            const size_t dequeued(
+                    head->id * SegmentSize +
+                    std::min(head->dequeue_index.load(std::memory_order_acquire), SegmentSize)
+            );
+            const size_t enqueued(
+                    tail->id * SegmentSize +
+                    std::min(tail->enqueue_index.load(std::memory_order_acquire), SegmentSize)
+            );
+
+            hazard_tail->pointer.store(nullptr, std::memory_order_release);
+            Hazards::maybe_clear_local();
+            return (enqueued > dequeued) ? enqueued - dequeued : 0;
+        }
+
+        // A push counts from the moment it claims its cell, before its value is published. So
+        // empty() can return false while the only pending push is still unpublished, and a pop()
+        // right after it may then return nullopt.
+        [[nodiscard]] auto empty() const -> bool {
+            HazardRecord* hazard(Hazards::acquire(0));
+            Segment* head(protect(head_, hazard));
+
+            const bool result(
+                    head->dequeue_index.load(std::memory_order_acquire) >=
+                            head->enqueue_index.load(std::memory_order_acquire) &&
+                    head->next.load(std::memory_order_acquire) == nullptr
+            );
+
+            Hazards::maybe_clear_local();
+            return result;
+        }
+    };
+
+    template <typename T, size_t SegmentSize>
+    typename segmented_queue<T, SegmentSize>::OrphanList segmented_queue<T, SegmentSize>::orphans_;
+    template <typename T, size_t SegmentSize>
+    thread_local typename segmented_queue<T, SegmentSize>::RetireList
+            segmented_queue<T, SegmentSize>::retire_list_;
+
+} // namespace seraph
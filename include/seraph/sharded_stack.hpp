@@ -0,0 +1,165 @@
+#pragma once
+
+#include "seraph/stack.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace seraph {
+    // Relaxed-LIFO stack for pool-style workloads where element order does not matter. Each thread
+    // is mapped to a home shard, a seraph::stack of its own, and only steals from other shards when
+    // its home shard is empty. Every shard shares one hazard domain, so a thread keeps a single
+    // hazard record no matter how many shards it touches.
+    template <typename T> class sharded_stack {
+      private:
+        // A steal moves a batch to the thief's home shard so the next pops stay local.
+        static constexpr size_t k_steal_batch{16};
+#if defined(__cpp_lib_hardware_interference_size)
+        static constexpr size_t k_destructive_interference_size{
+                std::hardware_destructive_interference_size
+        };
+#else
+        static constexpr size_t k_destructive_interference_size{64};
+#endif
+
+        using shard_type = stack<T>;
+
+        struct alignas(k_destructive_interference_size) Shard {
+            explicit Shard(std::shared_ptr<typename shard_type::hazard_domain> domain)
+                : items(std::move(domain)) {}
+
+            shard_type items;
+        };
+
+        // Threads are numbered round-robin on first use; the number is shared by every instance so
+        // threads spread evenly over the shards of each one.
+        static std::atomic<size_t> next_thread_slot_;
+        static thread_local size_t thread_slot_;
+
+        static size_t default_shard_count() noexcept {
+            return std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+
+        Shard& home_shard() noexcept {
+            return *shards_[home_index()];
+        }
+
+        size_t home_index() const noexcept {
+            if (thread_slot_ == 0) [[unlikely]] {
+                thread_slot_ = next_thread_slot_.fetch_add(1, std::memory_order_relaxed) + 1;
+            }
+
+            return (thread_slot_ - 1) % shards_.size();
+        }
+
+        // Visits the other shards starting after the home shard. The first value found is returned
+        // and the rest of the stolen batch is pushed onto the home shard. The batch lives in a
+        // fixed array, so a pop that finds every shard empty does not allocate.
+        std::optional<T> steal(size_t home) {
+            std::array<std::optional<T>, k_steal_batch> stolen;
+
+            for (size_t iii{1}; iii < shards_.size(); ++iii) {
+                Shard& victim(*shards_[(home + iii) % shards_.size()]);
+                const size_t count(victim.items.pop_bulk(k_steal_batch, stolen.begin()));
+
+                if (count == 0) {
+                    continue;
+                }
+
+                if (count > 1) {
+                    auto leftovers(
+                            std::views::counted(stolen.begin() + 1, count - 1)
+                            | std::views::transform([](std::optional<T>& value) -> T&& {
+                                  return std::move(*value);
+                              })
+                    );
+                    shards_[home]->items.push_range(leftovers.begin(), leftovers.end());
+                }
+
+                return std::move(stolen.front());
+            }
+
+            return std::nullopt;
+        }
+
+        std::shared_ptr<typename shard_type::hazard_domain> domain_;
+        std::vector<std::unique_ptr<Shard>> shards_;
+
+      public:
+        sharded_stack() : sharded_stack(default_shard_count()) {}
+
+        explicit sharded_stack(size_t shard_count)
+            : domain_(std::make_shared<typename shard_type::hazard_domain>()) {
+            shards_.reserve(std::max<size_t>(1, shard_count));
+
+            for (size_t iii{0}; iii < std::max<size_t>(1, shard_count); ++iii) {
+                shards_.push_back(std::make_unique<Shard>(domain_));
+            }
+        }
+
+        sharded_stack(const sharded_stack&) = delete;
+        sharded_stack& operator=(const sharded_stack&) = delete;
+
+        void push(const T& value) {
+            home_shard().items.push(value);
+        }
+
+        void push(T&& value) {
+            home_shard().items.push(std::move(value));
+        }
+
+        template <typename... Args> void emplace(Args&&... args) {
+            home_shard().items.emplace(std::forward<Args>(args)...);
+        }
+
+        // Pops from the home shard, stealing from the others when it is empty. Values pushed by
+        // the same thread come back in LIFO order; across threads there is no ordering guarantee.
+        std::optional<T> pop() {
+            const size_t home(home_index());
+
+            if (std::optional<T> result = shards_[home]->items.pop()) {
+                return result;
+            }
+
+            return steal(home);
+        }
+
+        // Not a snapshot: shards are read one after another.
+        bool empty() const {
+            return std::all_of(shards_.begin(), shards_.end(), [](const auto& shard) {
+                return shard->items.empty();
+            });
+        }
+
+        size_t size() const {
+            size_t total{0};
+
+            for (const auto& shard : shards_) {
+                total += shard->items.size();
+            }
+
+            return total;
+        }
+
+        size_t shard_count() const noexcept {
+            return shards_.size();
+        }
+
+        const std::shared_ptr<typename shard_type::hazard_domain>& domain() const noexcept {
+            return domain_;
+        }
+    };
+
+    template <typename T> std::atomic<size_t> sharded_stack<T>::next_thread_slot_{0};
+
+    template <typename T> thread_local size_t sharded_stack<T>::thread_slot_{0};
+
+} // namespace seraph
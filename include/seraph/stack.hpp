@@ -1,28 +1,126 @@
 #pragma once
 
 #include "locks.hpp"
+#include "seraph/node_cache.hpp"
 
 #include <algorithm>
 #include <array>
 #include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
-#include <exception>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
 #include <mutex>
 #include <new>
 #include <optional>
-#include <shared_mutex>
 #include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace seraph {
-    template <typename T> class stack {
+    // Signal a stack uses to decide when to switch modes.
+    //
+    // active_operations: every operation counts itself in and out of a shared counter and
+    // promotion follows the number of overlapping operations. Precise, but costs two shared
+    // read-modify-writes per call even when a single thread uses the stack.
+    //
+    // lock_failures: promotion follows failed try_lock() calls on the vector-mode spinlock and
+    // demotion follows per-thread samples without failed head CASes. Uncontended operations only
+    // touch thread-local counters.
+    enum class contention_detector { active_operations, lock_failures };
+
+    // When a stack switches modes. A stack can be given a new policy at any time with
+    // set_promotion_policy(), for instance one derived from the rates in get_contention_stats().
+    //
+    // thread_threshold: active_operations only, the number of overlapping operations that counts
+    // as contended.
+    // promotion_streak: contended operations in a row (active_operations) or failed lock attempts
+    // (lock_failures) before promoting.
+    // demotion_streak: uncontended operations in a row before demoting. It is much longer than the
+    // promotion streak, so a stack near the threshold does not flap between modes.
+    //
+    // The defaults promote quickly under practical contention on a four-core machine.
+    struct promotion_policy {
+        contention_detector detector{contention_detector::lock_failures};
+        size_t thread_threshold{3};
+        size_t promotion_streak{64};
+        size_t demotion_streak{4096};
+    };
+
+    // Totals since the stack was created. Failures are counted on paths that already lost a race;
+    // divide by the caller's own operation count for a rate.
+    struct contention_stats {
+        size_t lock_failures{0};
+        size_t cas_failures{0};
+        size_t promotions{0};
+        size_t demotions{0};
+    };
+
+    // How a stack's CAS mode keeps a pop from acting on a node another thread already reclaimed.
+    //
+    // hazard_pointer_cas: a pop publishes the head in a hazard pointer and re-validates it, and
+    // popped nodes are retired and scanned before reuse.
+    //
+    // tagged_pointer_cas: the head is a {pointer, tag} pair updated with a double-width CAS, and
+    // nodes come from a pool that never returns memory while the hazard domain lives. A stale pop
+    // can still read a reused node but its CAS fails on the tag, so pops publish no hazards and
+    // nothing is scanned. The stack has no top() under this policy, since without a hazard a
+    // reader cannot keep the top value alive while it copies it.
+    //
+    // unrolled_cas: hazard pointers as above, but the list is made of chunks of about one cache
+    // line, each holding several values. The head carries the number of values in its chunk, so a
+    // pop inside a chunk touches one line and a chunk allocation covers many pushes.
+    struct hazard_pointer_cas {};
+    struct tagged_pointer_cas {
+        // Shape of the {pointer, tag} head the policy updates with one double-width CAS.
+        struct alignas(2 * sizeof(void*)) head_layout {
+            void* pointer;
+            std::uint64_t tag;
+        };
+    };
+    struct unrolled_cas {};
+
+    // Whether stack<T, tagged_pointer_cas> compiles on this target: the policy needs the head CAS
+    // to be always lock-free. Apple clang on ARM64 inlines it (CASP); GCC routes 16-byte atomics
+    // through libatomic and reports them as not lock-free, so code that names the policy should
+    // branch on this with `if constexpr`.
+    template <typename T>
+    inline constexpr bool tagged_pointer_cas_supported{
+            std::atomic<tagged_pointer_cas::head_layout>::is_always_lock_free
+    };
+
+    // Allocator supplies both the vector-mode buffer and the CAS-mode nodes, e.g.
+    // std::pmr::polymorphic_allocator<T> over a monotonic arena. Nodes of the default allocator
+    // come from a node cache shared by every stack of the same type; any other allocator is used
+    // directly and must be safe to call from every thread that uses the stack.
+    //
+    // Lock guards the vector mode. Spinlock is a test-and-test-and-set lock, cheapest while few
+    // threads collide; McsLock queues waiters so each spins on its own cache line, which holds up
+    // better when many threads pile onto the lock before the stack promotes. Any type with lock(),
+    // try_lock() and unlock() works.
+    template <
+            typename T,
+            typename CasPolicy = hazard_pointer_cas,
+            typename Allocator = std::allocator<T>,
+            typename Lock = Spinlock>
+    class stack {
+      public:
+        class hazard_domain;
+        using allocator_type = Allocator;
+
       private:
-        // Starts in a spinlock-protected vector mode and promotes once to lock-free CAS.
+        // Starts in a spinlock-protected vector mode, promotes to lock-free CAS under contention and
+        // demotes back once operations stop overlapping.
 
-        // Fast promotion under practical workload contention.
-        static constexpr size_t k_default_thread_threshold{3};
-        static constexpr size_t k_default_streak_threshold{64};
+        static constexpr promotion_policy k_default_policy{};
+        // Operations per thread between two contention samples of the lock_failures detector.
+        static constexpr size_t k_contention_sample_period{256};
 #if defined(__cpp_lib_hardware_interference_size)
         static constexpr size_t k_destructive_interference_size{
                 std::hardware_destructive_interference_size
@@ -31,286 +129,2708 @@ namespace seraph {
         static constexpr size_t k_destructive_interference_size{64};
 #endif
 
-        struct Node {
+        static constexpr bool k_default_allocator{std::is_same_v<Allocator, std::allocator<T>>};
+        static constexpr bool k_tagged_cas{std::is_same_v<CasPolicy, tagged_pointer_cas>};
+        static constexpr bool k_unrolled_cas{std::is_same_v<CasPolicy, unrolled_cas>};
+
+        static_assert(
+                k_tagged_cas || k_unrolled_cas || std::is_same_v<CasPolicy, hazard_pointer_cas>,
+                "CasPolicy must be hazard_pointer_cas, tagged_pointer_cas or unrolled_cas"
+        );
+
+        // `next` is atomic because under tagged_pointer_cas a stale pop may read it while the node
+        // is reused, and a consume_all restore may relink it under a for_each walk. Accesses are
+        // relaxed except that restore and the walk, so most compile to plain loads and stores.
+        struct ListNode {
             T value;
-            Node* next;
+            std::atomic<ListNode*> next;
 
             template <typename... Args>
-            Node(Node* n, Args&&... args) : value(std::forward<Args>(args)...), next(n) {}
+            ListNode(ListNode* n, Args&&... args) : value(std::forward<Args>(args)...), next(n) {}
+        };
+
+        // unrolled_cas node. The head and `below` hold a chunk address with the number of values
+        // in that chunk in the low bits, so the chunk alignment exceeds the slot count. Slots are
+        // claimed in order and never reused while the chunk lives: each slot is written by one
+        // pusher and moved out by at most one popper, and a push that finds its slot already used
+        // starts a new chunk instead.
+        static constexpr size_t k_chunk_bytes{64};
+        static constexpr size_t k_chunk_alignment{std::max(k_chunk_bytes, alignof(T))};
+        // `below`, `lingering` and `claimed`: 20 bytes, which leaves 11 int slots in a chunk.
+        static constexpr size_t k_chunk_header{2 * sizeof(void*) + sizeof(std::uint32_t)};
+        static constexpr size_t k_chunk_slots{std::clamp<size_t>(
+                (k_chunk_bytes - k_chunk_header) / sizeof(T), 2, k_chunk_alignment - 1
+        )};
+        static constexpr std::uintptr_t k_chunk_count_mask{k_chunk_alignment - 1};
+
+        struct alignas(k_chunk_alignment) Chunk {
+            explicit Chunk(std::uintptr_t b) : below(b) {}
+
+            ~Chunk() {
+                for (std::uint64_t bits(lingering.load(std::memory_order_relaxed)); bits != 0;
+                     bits &= bits - 1) {
+                    std::destroy_at(slot(static_cast<size_t>(std::countr_zero(bits))));
+                }
+            }
+
+            void* slot_address(size_t index) noexcept {
+                return storage + index * sizeof(T);
+            }
+
+            T* slot(size_t index) noexcept {
+                return std::launder(reinterpret_cast<T*>(slot_address(index)));
+            }
+
+            // Packed head of the chain below this chunk. Atomic because a consume_all restore
+            // relinks the bottom chunk of a detached chain that a for_each walk or a stale pop may
+            // still be reading; that store releases and the walk acquires, everything else is
+            // relaxed.
+            std::atomic<std::uintptr_t> below;
+            // Popped slots whose value was copied out for a concurrent top_visit() and is
+            // destroyed with the chunk.
+            std::atomic<std::uint64_t> lingering{0};
+            std::atomic<std::uint32_t> claimed{0};
+            alignas(T) std::byte storage[k_chunk_slots * sizeof(T)];
+        };
+
+        using Node = std::conditional_t<k_unrolled_cas, Chunk, ListNode>;
+        using NodeAllocator =
+                typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+        using NodeTraits = std::allocator_traits<NodeAllocator>;
+        using NodeStorage = node_cache<sizeof(Node), alignof(Node)>;
+        using spin_vector = std::vector<T, Allocator>;
+
+        static_assert(
+                std::is_same_v<typename NodeTraits::pointer, Node*>,
+                "Allocator must hand out raw pointers"
+        );
+
+        // Vector-mode storage. Values live in segments that are never moved: the first two hold
+        // k_spin_segment values each and every later one twice as many as the one before, so an
+        // index finds its segment with one bit_width, and a push that fills the last segment
+        // allocates the next one instead of copying every value while the lock is held. Segments
+        // stay allocated when the stack shrinks, the way a vector keeps its capacity.
+        static constexpr size_t k_spin_segment{
+                std::bit_ceil(std::max<size_t>(16, 1024 / sizeof(T)))
+        };
+
+        class SpinStorage {
+          public:
+            explicit SpinStorage(const Allocator& allocator) noexcept : allocator_(allocator) {}
+
+            // Storages of one stack share the domain's allocator, so segments can change hands.
+            SpinStorage(SpinStorage&& other) noexcept
+                : allocator_(other.allocator_),
+                  segments_(std::exchange(other.segments_, {})),
+                  size_(std::exchange(other.size_, 0)) {}
+
+            SpinStorage& operator=(SpinStorage&& other) noexcept {
+                SpinStorage(std::move(other)).swap(*this);
+                return *this;
+            }
+
+            ~SpinStorage() {
+                if constexpr (!std::is_trivially_destructible_v<T>) {
+                    while (size_ != 0) {
+                        pop_back();
+                    }
+                }
+
+                for (size_t segment{0}; segment < k_max_segments; ++segment) {
+                    if (segments_[segment]) {
+                        Traits::deallocate(
+                                allocator_, segments_[segment], segment_capacity(segment)
+                        );
+                    }
+                }
+            }
+
+            SpinStorage(const SpinStorage&) = delete;
+            SpinStorage& operator=(const SpinStorage&) = delete;
+
+            size_t size() const noexcept {
+                return size_;
+            }
+
+            bool empty() const noexcept {
+                return size_ == 0;
+            }
+
+            T& operator[](size_t index) noexcept {
+                const size_t segment(segment_of(index));
+                return segments_[segment][index - segment_base(segment)];
+            }
+
+            const T& operator[](size_t index) const noexcept {
+                const size_t segment(segment_of(index));
+                return segments_[segment][index - segment_base(segment)];
+            }
+
+            T& back() noexcept {
+                return (*this)[size_ - 1];
+            }
+
+            const T& back() const noexcept {
+                return (*this)[size_ - 1];
+            }
+
+            template <typename... Args> void emplace_back(Args&&... args) {
+                const size_t segment(segment_of(size_));
+
+                if (!segments_[segment]) [[unlikely]] {
+                    allocate_segment(segment);
+                }
+
+                Traits::construct(
+                        allocator_,
+                        segments_[segment] + (size_ - segment_base(segment)),
+                        std::forward<Args>(args)...
+                );
+                ++size_;
+            }
+
+            void pop_back() noexcept {
+                --size_;
+                Traits::destroy(allocator_, &(*this)[size_]);
+            }
+
+            // Allocates the segments below `capacity`, so filling them allocates nothing.
+            void reserve(size_t capacity) {
+                for (size_t segment{0};
+                     segment < k_max_segments && segment_base(segment) < capacity;
+                     ++segment) {
+                    if (!segments_[segment]) {
+                        allocate_segment(segment);
+                    }
+                }
+            }
+
+            void swap(SpinStorage& other) noexcept {
+                std::swap(segments_, other.segments_);
+                std::swap(size_, other.size_);
+            }
+
+          private:
+            using Traits = std::allocator_traits<Allocator>;
+
+            static constexpr size_t k_first_shift{
+                    static_cast<size_t>(std::countr_zero(k_spin_segment))
+            };
+            static constexpr size_t k_max_segments{
+                    std::numeric_limits<size_t>::digits - k_first_shift + 1
+            };
+
+            static size_t segment_of(size_t index) noexcept {
+                return static_cast<size_t>(std::bit_width(index >> k_first_shift));
+            }
+
+            static size_t segment_base(size_t segment) noexcept {
+                return segment == 0 ? 0 : k_spin_segment << (segment - 1);
+            }
+
+            static size_t segment_capacity(size_t segment) noexcept {
+                return segment == 0 ? k_spin_segment : k_spin_segment << (segment - 1);
+            }
+
+            void allocate_segment(size_t segment) {
+                segments_[segment] = Traits::allocate(allocator_, segment_capacity(segment));
+            }
+
+            [[no_unique_address]] Allocator allocator_;
+            std::array<T*, k_max_segments> segments_{};
+            size_t size_{0};
+        };
+
+        // Hazard records form a growable list per hazard_domain. A record is owned by one thread at
+        // a time and also carries that thread's retired nodes for the domain, so nodes of one stack
+        // are only ever checked against the hazards of its own domain. `walk` is a second hazard
+        // for hand-over-hand traversal below the head. `active` names the stack the owner is
+        // currently operating on, the outermost one when operations nest (see ModeGuard), which is
+        // what a mode switch waits on.
+        static constexpr uint32_t k_record_free{0};
+        static constexpr uint32_t k_record_owned{1};
+        static constexpr uint32_t k_record_orphaned{2};
+
+        struct alignas(k_destructive_interference_size) HazardRecord {
+            std::atomic<Node*> pointer{nullptr};
+            std::atomic<Node*> walk{nullptr};
+            std::atomic<const stack*> active{nullptr};
+            std::atomic<uint32_t> state{k_record_owned};
+            HazardRecord* next{nullptr};
+            std::vector<Node*> retired;
+            // tagged_pointer_cas only: pooled nodes whose value is destroyed, linked through
+            // `next` so that giving one back never allocates.
+            Node* free_nodes{nullptr};
+            size_t free_count{0};
+        };
+
+        // Head of the CAS-mode list and content of an elimination slot. The tag counts updates so
+        // that a CAS expecting an old {pointer, tag} fails even if the pointer was reused.
+        struct alignas(2 * sizeof(void*)) TaggedPointer {
+            Node* pointer{nullptr};
+            std::uint64_t tag{0};
+
+            friend bool operator==(const TaggedPointer&, const TaggedPointer&) = default;
+        };
+
+        // A double-width CAS that falls back to libatomic's lock table would serialize every
+        // head update behind a hidden mutex and needs -latomic at link time. See
+        // tagged_pointer_cas_supported.
+        static_assert(
+                !k_tagged_cas || std::atomic<TaggedPointer>::is_always_lock_free,
+                "tagged_pointer_cas needs a lock-free double-width CAS on this target"
+        );
+        static_assert(
+                !k_tagged_cas || sizeof(TaggedPointer) == sizeof(tagged_pointer_cas::head_layout)
+        );
+
+        using head_type = std::conditional_t<
+                k_tagged_cas,
+                TaggedPointer,
+                std::conditional_t<k_unrolled_cas, std::uintptr_t, Node*>>;
+
+        static Node* pointer_of(Node* head) noexcept {
+            return head;
+        }
+
+        static Node* pointer_of(const TaggedPointer& head) noexcept {
+            return head.pointer;
+        }
+
+        static Node* pointer_of(std::uintptr_t head) noexcept {
+            return reinterpret_cast<Node*>(head & ~k_chunk_count_mask);
+        }
+
+        static size_t count_of(std::uintptr_t head) noexcept {
+            return head & k_chunk_count_mask;
+        }
+
+        static std::uintptr_t pack(Node* chunk, size_t count) noexcept {
+            return reinterpret_cast<std::uintptr_t>(chunk) | count;
+        }
+
+        // The value that replaces `current` when `pointer` is installed.
+        static Node* successor(Node*, Node* pointer) noexcept {
+            return pointer;
+        }
+
+        static TaggedPointer successor(const TaggedPointer& current, Node* pointer) noexcept {
+            return TaggedPointer{pointer, current.tag + 1};
+        }
+
+        // Each thread caches the records it owns keyed by domain id, most recent first, so the fast
+        // path never walks the shared record list.
+        static constexpr size_t k_local_record_slots{8};
+        static constexpr size_t k_retire_scan_threshold{64};
+
+        struct LocalRecord {
+            std::uint64_t domain_id{0};
+            HazardRecord* record{nullptr};
+        };
+
+        // A record pushed out of `entries` while an outer frame still uses it, through an
+        // announcement or a published hazard, is kept in `spilled` rather than given back, so the
+        // frame's record stays owned and a nested operation on that domain finds it again.
+        struct LocalRecords {
+            std::array<LocalRecord, k_local_record_slots> entries{};
+            std::vector<LocalRecord> spilled;
+
+            ~LocalRecords() {
+                for (LocalRecord& entry : entries) {
+                    if (entry.record) {
+                        release_record(entry.record);
+                        entry = LocalRecord{};
+                    }
+                }
+
+                for (LocalRecord& entry : spilled) {
+                    release_record(entry.record);
+                }
+
+                spilled.clear();
+            }
+        };
+
+        static thread_local LocalRecords local_records_;
+        static thread_local std::vector<Node*> hazard_snapshot_;
+
+        // Elimination layer. A push that loses the head CAS offers its node in a slot for a short
+        // window; a pop that loses the head CAS takes any offered node instead of retrying.
+        static constexpr size_t k_elimination_slots{4};
+        static constexpr size_t k_elimination_spin{64};
+
+        struct alignas(k_destructive_interference_size) EliminationSlot {
+            std::atomic<head_type> offer{};
+        };
+
+        static thread_local size_t elimination_hint_;
+
+        // Counter stripes. A CAS-mode push or pop adjusts only the size stripe of the calling
+        // thread, so the counter never becomes a second contended line next to the head, and
+        // failed lock attempts and head CASes are tallied the same way. A size stripe can go
+        // negative when values pushed through one stripe are popped through another; only the sum
+        // is meaningful.
+        static constexpr size_t k_counter_stripes{8};
+
+        struct alignas(k_destructive_interference_size) CounterStripe {
+            std::atomic<std::ptrdiff_t> count{0};
+            std::atomic<size_t> lock_failures{0};
+            std::atomic<size_t> cas_failures{0};
+        };
+
+        static thread_local size_t counter_stripe_;
+        static std::atomic<size_t> next_counter_stripe_;
+
+        // lock_failures sampling windows. Each thread keeps one window per stack it used recently,
+        // keyed by address and most recent first like the hazard records; a stack that drops off
+        // the end starts a fresh window when it comes back.
+        static constexpr size_t k_contention_sample_slots{8};
+
+        struct ContentionSample {
+            const stack* owner{nullptr};
+            size_t operations{0};
+            size_t failures{0};
+        };
+
+        struct ContentionSamples {
+            std::array<ContentionSample, k_contention_sample_slots> entries{};
+        };
+
+        static thread_local ContentionSamples contention_samples_;
+
+        // Mode word. Operations read it once after announcing themselves in their hazard record; a
+        // switch sets k_mode_switching, waits for announcements on this stack to drain, converts
+        // the storage and then publishes the new mode.
+        static constexpr uint32_t k_mode_spin{0};
+        static constexpr uint32_t k_mode_cas{1};
+        static constexpr uint32_t k_mode_switching{2};
+        static constexpr size_t k_drain_spin{64};
+
+        // Values copied per lock hold by for_each() in vector mode.
+        static constexpr size_t k_snapshot_chunk{256};
+
+        // tagged_pointer_cas pool batches: a thread's free nodes beyond k_pool_capacity go to the
+        // domain k_pool_batch at a time.
+        static constexpr size_t k_pool_batch{64};
+        static constexpr size_t k_pool_capacity{2 * k_pool_batch};
+
+        class ContentionScope {
+          public:
+            explicit ContentionScope(stack& stack)
+                : stack_(stack),
+                  counted_(stack.detector_.load(std::memory_order_relaxed) ==
+                           contention_detector::active_operations) {
+                if (!counted_) [[likely]] {
+                    stack_.sample_operation();
+                    return;
+                }
+
+                const size_t active_now(
+                        stack_.active_ops_.fetch_add(1, std::memory_order_relaxed) + 1
+                );
+                stack_.observe_contention(active_now);
+            }
+
+            ~ContentionScope() {
+                if (counted_) {
+                    stack_.active_ops_.fetch_sub(1, std::memory_order_relaxed);
+                }
+            }
+
+            ContentionScope(const ContentionScope&) = delete;
+            ContentionScope& operator=(const ContentionScope&) = delete;
+
+          private:
+            stack& stack_;
+            const bool counted_;
+        };
+
+        class ModeGuard {
+          public:
+            explicit ModeGuard(const stack& owner)
+                : owner_(owner),
+                  record_(owner.acquire_hazard()),
+                  previous_(record_->active.load(std::memory_order_relaxed)),
+                  nested_(previous_ != nullptr && previous_ != &owner) {
+                while (true) {
+                    // Dekker-style pairing with begin_mode_switch: either this load sees the
+                    // switching bit, or the switcher sees the announcement and waits for it.
+                    announce();
+                    mode_ = owner_.mode_.load(std::memory_order_seq_cst);
+
+                    if ((mode_ & k_mode_switching) == 0) [[likely]] {
+                        return;
+                    }
+
+                    withdraw();
+                    owner_.mode_.wait(mode_, std::memory_order_acquire);
+                }
+            }
+
+            ~ModeGuard() {
+                withdraw();
+            }
+
+            ModeGuard(const ModeGuard&) = delete;
+            ModeGuard& operator=(const ModeGuard&) = delete;
+
+            bool using_cas() const noexcept {
+                return (mode_ & k_mode_cas) != 0;
+            }
+
+          private:
+            // A record has one announcement per thread. A guard taken while the thread is inside
+            // an operation on another stack of the same domain, such as a sibling shard or a
+            // visitor's own stack, counts itself in nested_guards_ instead, so the outer
+            // announcement stays visible to the outer stack's switches.
+            void announce() noexcept {
+                if (nested_) [[unlikely]] {
+                    owner_.nested_guards_.fetch_add(1, std::memory_order_seq_cst);
+                }
+                else {
+                    record_->active.store(&owner_, std::memory_order_seq_cst);
+                }
+            }
+
+            void withdraw() noexcept {
+                if (nested_) [[unlikely]] {
+                    owner_.nested_guards_.fetch_sub(1, std::memory_order_release);
+                }
+                else {
+                    record_->active.store(previous_, std::memory_order_release);
+                }
+            }
+
+            const stack& owner_;
+            HazardRecord* record_;
+            const stack* const previous_;
+            const bool nested_;
+            uint32_t mode_{k_mode_spin};
         };
 
-        struct alignas(k_destructive_interference_size) HazardRecord {
-            std::atomic<std::thread::id> owner;
-            std::atomic<Node*> pointer;
-        };
+        // Gives the record back to its domain. Retired nodes stay with the record for the next owner.
+        static void release_record(HazardRecord* record) noexcept {
+            uint32_t expected{k_record_owned};
+            record->pointer.store(nullptr, std::memory_order_release);
+
+            if (!record->state.compare_exchange_strong(
+                        expected,
+                        k_record_free,
+                        std::memory_order_acq_rel,
+                        std::memory_order_acquire
+                )) {
+                // The domain was destroyed while this thread still held the record.
+                delete record;
+            }
+        }
+
+        HazardRecord* acquire_hazard() const {
+            LocalRecords& local(local_records_);
+
+            if (local.entries[0].domain_id == domain_->id_) [[likely]] {
+                return local.entries[0].record;
+            }
+
+            return acquire_hazard_slow(local);
+        }
+
+        HazardRecord* acquire_hazard_slow(LocalRecords& local) const {
+            size_t index{1};
+
+            while (index < k_local_record_slots && local.entries[index].domain_id != domain_->id_) {
+                ++index;
+            }
+
+            LocalRecord found{};
+
+            if (index < k_local_record_slots) {
+                found = local.entries[index];
+            }
+            else {
+                index = evict_local_record(local);
+                found = take_spilled_record(local);
+
+                if (!found.record) {
+                    found = LocalRecord{
+                            .domain_id = domain_->id_,
+                            .record = domain_->acquire_record(),
+                    };
+                }
+            }
+
+            for (; index > 0; --index) {
+                local.entries[index] = local.entries[index - 1];
+            }
+
+            local.entries[0] = found;
+            return found.record;
+        }
+
+        // Only the owner writes these, so relaxed loads see its own latest stores.
+        static bool record_in_use(const HazardRecord* record) noexcept {
+            return record->active.load(std::memory_order_relaxed) ||
+                   record->pointer.load(std::memory_order_relaxed) ||
+                   record->walk.load(std::memory_order_relaxed);
+        }
+
+        // Frees the least recently used slot that can be given up and returns its index. A record
+        // still in use by an outer frame is never given back; if every slot holds one, the last
+        // is spilled.
+        static size_t evict_local_record(LocalRecords& local) {
+            for (size_t index(k_local_record_slots - 1); index > 0; --index) {
+                LocalRecord& entry(local.entries[index]);
+
+                if (!entry.record || !record_in_use(entry.record)) {
+                    if (entry.record) {
+                        release_record(entry.record);
+                    }
+
+                    entry = LocalRecord{};
+                    return index;
+                }
+            }
+
+            LocalRecord& last(local.entries[k_local_record_slots - 1]);
+            local.spilled.push_back(last);
+            last = LocalRecord{};
+            return k_local_record_slots - 1;
+        }
+
+        LocalRecord take_spilled_record(LocalRecords& local) const {
+            for (size_t iii{0}; iii < local.spilled.size(); ++iii) {
+                if (local.spilled[iii].domain_id == domain_->id_) {
+                    const LocalRecord found(local.spilled[iii]);
+                    local.spilled.erase(local.spilled.begin() + static_cast<std::ptrdiff_t>(iii));
+                    return found;
+                }
+            }
+
+            return LocalRecord{};
+        }
+
+        // Takes over the retired nodes of records nobody owns, e.g. because their thread exited,
+        // so they do not wait for the record's next owner to retire enough nodes of its own. A
+        // record is claimed like acquire_record() does and handed back empty.
+        void adopt_orphans(HazardRecord* record) {
+            for (HazardRecord* other(domain_->records_.load(std::memory_order_acquire)); other;
+                 other = other->next) {
+                uint32_t expected{k_record_free};
+
+                if (other == record ||
+                    other->state.load(std::memory_order_relaxed) != k_record_free ||
+                    !other->state.compare_exchange_strong(
+                            expected,
+                            k_record_owned,
+                            std::memory_order_acq_rel,
+                            std::memory_order_relaxed
+                    )) {
+                    continue;
+                }
+
+                try {
+                    record->retired.insert(
+                            record->retired.end(), other->retired.begin(), other->retired.end()
+                    );
+                }
+                catch (...) {
+                    other->state.store(k_record_free, std::memory_order_release);
+                    throw;
+                }
+
+                other->retired.clear();
+                other->state.store(k_record_free, std::memory_order_release);
+            }
+        }
+
+        // Cost follows the number of records in the domain, i.e. the peak number of threads that
+        // used it, rather than a fixed table size.
+        void scan(HazardRecord* record) {
+            std::vector<Node*>& hazards(hazard_snapshot_);
+            hazards.clear();
+            adopt_orphans(record);
+
+            // A for_each() on any stack of the domain may be walking nodes unlinked after it began.
+            // It registers before reading the head, so a scan that sees no walker can only free
+            // nodes that were unlinked before every walk now running started.
+            if (domain_->walkers_.load(std::memory_order_seq_cst) != 0) [[unlikely]] {
+                return;
+            }
+
+            // Pairs with the seq_cst hazard publish in readers: either the reader sees the node
+            // unlinked, or this scan sees the reader's hazard.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            for (HazardRecord* other(domain_->records_.load(std::memory_order_acquire)); other;
+                 other = other->next) {
+                Node* hazard_node(other->pointer.load(std::memory_order_acquire));
+                Node* walk_node(other->walk.load(std::memory_order_acquire));
+
+                if (hazard_node) {
+                    hazards.push_back(hazard_node);
+                }
+
+                if (walk_node) {
+                    hazards.push_back(walk_node);
+                }
+            }
+
+            std::sort(hazards.begin(), hazards.end());
+
+            std::vector<Node*>& retired(record->retired);
+            size_t write_index{0};
+
+            for (size_t read_index{0}; read_index < retired.size(); ++read_index) {
+                Node* retired_node(retired[read_index]);
+
+                if (std::binary_search(hazards.begin(), hazards.end(), retired_node)) {
+                    retired[write_index++] = retired_node;
+                }
+                else {
+                    destroy_node(retired_node);
+                }
+            }
+
+            retired.resize(write_index);
+        }
+
+        void retire(HazardRecord* record, Node* node) {
+            record->retired.push_back(node);
+
+            // Amortizes the O(records) scan over at least twice as many retirements.
+            const size_t threshold(std::max(
+                    k_retire_scan_threshold,
+                    2 * domain_->record_count_.load(std::memory_order_relaxed)
+            ));
+
+            if (record->retired.size() >= threshold) {
+                scan(record);
+            }
+        }
+
+        template <typename... Args> Node* create_node(Node* next, Args&&... args) {
+            void* storage(domain_->take_storage());
+
+            try {
+                return ::new (storage) Node(next, std::forward<Args>(args)...);
+            }
+            catch (...) {
+                domain_->recycle_storage(storage);
+                throw;
+            }
+        }
+
+        void destroy_node(Node* node) const noexcept {
+            domain_->destroy_node(node);
+        }
+
+        // An empty chunk from the node cache; values are constructed into its slots afterwards.
+        Node* create_chunk(std::uintptr_t below) {
+            return ::new (domain_->take_storage()) Chunk(below);
+        }
+
+        // tagged_pointer_cas node pool. Nodes are only freed with their hazard domain, so a stale
+        // pop can read `next` from a node that was popped and reused; the tag then fails its CAS.
+        // Each thread keeps free nodes in its hazard record and trades batches through the domain.
+        // A reused node keeps its `next` object alive and only gets a new value; while the node is
+        // free, `next` links the free list it sits on.
+        template <typename... Args> Node* create_pooled_node(Node* next, Args&&... args) {
+            HazardRecord* record(acquire_hazard());
+
+            if (!record->free_nodes) {
+                refill_free_nodes(*record);
+            }
+
+            if (!record->free_nodes) {
+                void* storage(domain_->allocate_storage());
+                NodeStorage::count_miss();
+
+                try {
+                    return ::new (storage) Node(next, std::forward<Args>(args)...);
+                }
+                catch (...) {
+                    domain_->deallocate_storage(storage);
+                    throw;
+                }
+            }
+
+            Node* node(record->free_nodes);
+            ::new (static_cast<void*>(std::addressof(node->value))) T(std::forward<Args>(args)...);
+            record->free_nodes = node->next.load(std::memory_order_relaxed);
+            --record->free_count;
+            node->next.store(next, std::memory_order_relaxed);
+            NodeStorage::count_hit();
+            return node;
+        }
+
+        // Never allocates, so ~stack and the reclaim paths cannot throw from here. A thread whose
+        // most recent record belongs to another domain, or that has none, does not look one up
+        // but hands the node straight to the domain's pool.
+        void release_pooled_node(Node* node) noexcept {
+            std::destroy_at(std::addressof(node->value));
+            const LocalRecord& local(local_records_.entries[0]);
+
+            if (local.domain_id != domain_->id_) [[unlikely]] {
+                SpinlockGuard guard(domain_->pool_lock_);
+                node->next.store(domain_->pool_, std::memory_order_relaxed);
+                domain_->pool_ = node;
+                return;
+            }
+
+            HazardRecord& record(*local.record);
+            node->next.store(record.free_nodes, std::memory_order_relaxed);
+            record.free_nodes = node;
+
+            if (++record.free_count > k_pool_capacity) {
+                spill_free_nodes(record);
+            }
+        }
+
+        // Moves the k_pool_batch most recently freed nodes to the domain's pool.
+        void spill_free_nodes(HazardRecord& record) noexcept {
+            Node* batch(record.free_nodes);
+            Node* batch_tail(batch);
+
+            for (size_t iii{1}; iii < k_pool_batch; ++iii) {
+                batch_tail = batch_tail->next.load(std::memory_order_relaxed);
+            }
+
+            record.free_nodes = batch_tail->next.load(std::memory_order_relaxed);
+            record.free_count -= k_pool_batch;
+
+            SpinlockGuard guard(domain_->pool_lock_);
+            batch_tail->next.store(domain_->pool_, std::memory_order_relaxed);
+            domain_->pool_ = batch;
+        }
+
+        // Takes up to k_pool_batch nodes from the domain's pool into an empty free list.
+        void refill_free_nodes(HazardRecord& record) noexcept {
+            SpinlockGuard guard(domain_->pool_lock_);
+            Node* batch(domain_->pool_);
+
+            if (!batch) {
+                return;
+            }
+
+            Node* batch_tail(batch);
+            size_t count{1};
+
+            for (Node* next; count < k_pool_batch &&
+                             (next = batch_tail->next.load(std::memory_order_relaxed));
+                 ++count) {
+                batch_tail = next;
+            }
+
+            domain_->pool_ = batch_tail->next.load(std::memory_order_relaxed);
+            batch_tail->next.store(nullptr, std::memory_order_relaxed);
+            record.free_nodes = batch;
+            record.free_count = count;
+        }
+
+        template <typename... Args> Node* make_node(Node* next, Args&&... args) {
+            if constexpr (k_tagged_cas) {
+                return create_pooled_node(next, std::forward<Args>(args)...);
+            }
+            else {
+                return create_node(next, std::forward<Args>(args)...);
+            }
+        }
+
+        // Destroys a node no other thread can reach any more.
+        void dispose_node(Node* node) {
+            if constexpr (k_tagged_cas) {
+                release_pooled_node(node);
+            }
+            else {
+                destroy_node(node);
+            }
+        }
+
+        void dispose_chain(Node* node) {
+            while (node) {
+                Node* next(node->next.load(std::memory_order_relaxed));
+                dispose_node(node);
+                node = next;
+            }
+        }
+
+        // Stripes are handed out round-robin on first use rather than hashed from the thread id,
+        // which keeps a handful of threads on distinct stripes.
+        static size_t counter_stripe() noexcept {
+            if (counter_stripe_ == 0) {
+                const size_t ticket(next_counter_stripe_.fetch_add(1, std::memory_order_relaxed));
+                counter_stripe_ = ticket % k_counter_stripes + 1;
+            }
+
+            return counter_stripe_ - 1;
+        }
+
+        void count_cas_push(size_t count) noexcept {
+            stripes_[counter_stripe()].count.fetch_add(
+                    static_cast<std::ptrdiff_t>(count), std::memory_order_relaxed
+            );
+        }
+
+        void count_cas_pop(size_t count) noexcept {
+            stripes_[counter_stripe()].count.fetch_sub(
+                    static_cast<std::ptrdiff_t>(count), std::memory_order_relaxed
+            );
+        }
+
+        // Only valid while no operation is in flight on the stack.
+        void reset_cas_size(size_t count) noexcept {
+            stripes_[0].count.store(static_cast<std::ptrdiff_t>(count), std::memory_order_relaxed);
+            for (size_t iii{1}; iii < k_counter_stripes; ++iii) {
+                stripes_[iii].count.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        static size_t elimination_start() noexcept {
+            if (elimination_hint_ == 0) {
+                elimination_hint_ = std::hash<std::thread::id>{}(std::this_thread::get_id()) | 1;
+            }
+
+            return elimination_hint_;
+        }
+
+        // Returns true when a concurrent pop consumed the node. Under hazard_pointer_cas the node
+        // stays hazard-protected while offered; under tagged_pointer_cas every offer bumps the slot
+        // tag. Either way the withdrawing CAS can never match a recycled node.
+        bool try_eliminate_push(Node* node) {
+            HazardRecord* hazard{nullptr};
+            const size_t start(elimination_start());
+
+            if constexpr (!k_tagged_cas) {
+                hazard = acquire_hazard();
+            }
+
+            for (size_t iii{0}; iii < k_elimination_slots; ++iii) {
+                EliminationSlot& slot(elimination_slots_[(start + iii) % k_elimination_slots]);
+                head_type expected(slot.offer.load(std::memory_order_relaxed));
+
+                if (pointer_of(expected) != nullptr) {
+                    continue;
+                }
+
+                if constexpr (!k_tagged_cas) {
+                    hazard->pointer.store(node, std::memory_order_release);
+                }
+
+                const head_type offered(successor(expected, node));
+
+                if (!slot.offer.compare_exchange_strong(
+                            expected,
+                            offered,
+                            std::memory_order_release,
+                            std::memory_order_relaxed
+                    )) {
+                    continue;
+                }
+
+                for (size_t spin{0}; spin < k_elimination_spin; ++spin) {
+                    if (slot.offer.load(std::memory_order_acquire) != offered) {
+                        break;
+                    }
+
+                    cpu_relax();
+                }
+
+                expected = offered;
+                const bool withdrawn(slot.offer.compare_exchange_strong(
+                        expected,
+                        successor(offered, nullptr),
+                        std::memory_order_relaxed,
+                        std::memory_order_relaxed
+                ));
+
+                if constexpr (!k_tagged_cas) {
+                    hazard->pointer.store(nullptr, std::memory_order_release);
+                }
+
+                return !withdrawn;
+            }
+
+            if constexpr (!k_tagged_cas) {
+                hazard->pointer.store(nullptr, std::memory_order_release);
+            }
+
+            return false;
+        }
+
+        // Takes an offered node, if any. The caller owns the returned node exclusively.
+        Node* try_eliminate_pop() {
+            const size_t start(elimination_start());
+
+            for (size_t iii{0}; iii < k_elimination_slots; ++iii) {
+                EliminationSlot& slot(elimination_slots_[(start + iii) % k_elimination_slots]);
+                head_type offered(slot.offer.load(std::memory_order_acquire));
+
+                if (pointer_of(offered) && slot.offer.compare_exchange_strong(
+                                                   offered,
+                                                   successor(offered, nullptr),
+                                                   std::memory_order_acquire,
+                                                   std::memory_order_relaxed
+                                           )) {
+                    return pointer_of(offered);
+                }
+            }
+
+            return nullptr;
+        }
+
+        template <typename... Args> void cas_emplace_impl(Args&&... args) {
+            if constexpr (k_unrolled_cas) {
+                unrolled_emplace_impl(std::forward<Args>(args)...);
+            }
+            else {
+                list_emplace_impl(std::forward<Args>(args)...);
+            }
+        }
+
+        template <typename... Args> void list_emplace_impl(Args&&... args) {
+            Node* new_node(make_node(nullptr, std::forward<Args>(args)...));
+            head_type old_head(cas_head_.load(std::memory_order_relaxed));
+
+            while (true) {
+                new_node->next.store(pointer_of(old_head), std::memory_order_relaxed);
+
+                if (cas_head_.compare_exchange_weak(
+                            old_head,
+                            successor(old_head, new_node),
+                            std::memory_order_seq_cst,
+                            std::memory_order_relaxed
+                    )) {
+                    count_cas_push(1);
+                    return;
+                }
+
+                note_cas_failure();
+
+                if (try_eliminate_push(new_node)) {
+                    return;
+                }
+
+                old_head = cas_head_.load(std::memory_order_relaxed);
+            }
+        }
+
+        template <typename InputIt> void cas_push_range_impl(InputIt first, InputIt last) {
+            if constexpr (k_unrolled_cas) {
+                unrolled_push_range_impl(first, last);
+            }
+            else {
+                list_push_range_impl(first, last);
+            }
+        }
+
+        // Links the range privately, then splices it in with a single head CAS. The last element
+        // ends up on top, as if pushed one by one.
+        template <typename InputIt> void list_push_range_impl(InputIt first, InputIt last) {
+            Node* top{nullptr};
+            Node* bottom{nullptr};
+            size_t count{0};
+
+            try {
+                for (; first != last; ++first) {
+                    top = make_node(top, *first);
+                    bottom = bottom ? bottom : top;
+                    ++count;
+                }
+            }
+            catch (...) {
+                dispose_chain(top);
+                throw;
+            }
+
+            if (!top) {
+                return;
+            }
+
+            splice_list(top, bottom);
+            count_cas_push(count);
+        }
+
+        // Installs a private chain from `top` down to `bottom` above the current head. As in
+        // splice_chunks(), a walk that reaches the old head through a restored chain sees the
+        // values pushed into it.
+        void splice_list(Node* top, Node* bottom) {
+            head_type old_head(cas_head_.load(std::memory_order_acquire));
+
+            while (true) {
+                bottom->next.store(pointer_of(old_head), std::memory_order_release);
+
+                if (cas_head_.compare_exchange_weak(
+                            old_head,
+                            successor(old_head, top),
+                            std::memory_order_seq_cst,
+                            std::memory_order_acquire
+                    )) {
+                    return;
+                }
+
+                note_cas_failure();
+            }
+        }
+
+        // Pop paths hand the popped value to `sink` as an rvalue and return whether there was one.
+        template <typename Sink> bool cas_pop_impl(Sink& sink) {
+            if constexpr (k_tagged_cas) {
+                return tagged_pop_impl(sink);
+            }
+            else if constexpr (k_unrolled_cas) {
+                return unrolled_pop_impl(sink);
+            }
+            else {
+                return hazard_pop_impl(sink);
+            }
+        }
+
+        template <typename Sink> bool hazard_pop_impl(Sink& sink) {
+            HazardRecord* hazard(acquire_hazard());
+            Node* old_head(cas_head_.load(std::memory_order_acquire));
+
+            while (old_head) {
+                hazard->pointer.store(old_head, std::memory_order_seq_cst);
+
+                if (cas_head_.load(std::memory_order_seq_cst) != old_head) {
+                    old_head = cas_head_.load(std::memory_order_acquire);
+                    continue;
+                }
+
+                Node* next(old_head->next.load(std::memory_order_relaxed));
+
+                if (cas_head_.compare_exchange_weak(
+                            old_head,
+                            next,
+                            std::memory_order_seq_cst,
+                            std::memory_order_relaxed
+                    )) {
+                    hazard->pointer.store(nullptr, std::memory_order_release);
+                    count_cas_pop(1);
+
+                    hand_over(old_head->value, top_may_be_visited(), sink);
+                    retire(hazard, old_head);
+                    return true;
+                }
+
+                note_cas_failure();
+
+                if (Node* eliminated = try_eliminate_pop()) {
+                    hazard->pointer.store(nullptr, std::memory_order_release);
+
+                    sink(std::move(eliminated->value));
+                    retire(hazard, eliminated);
+                    return true;
+                }
+
+                old_head = cas_head_.load(std::memory_order_acquire);
+            }
+
+            hazard->pointer.store(nullptr, std::memory_order_release);
+            return false;
+        }
+
+        // No hazard: `next` may come from a node that was popped and reused meanwhile, in which
+        // case the head tag has moved on and the CAS fails.
+        template <typename Sink> bool tagged_pop_impl(Sink& sink) {
+            TaggedPointer old_head(cas_head_.load(std::memory_order_acquire));
+
+            while (old_head.pointer) {
+                Node* next(old_head.pointer->next.load(std::memory_order_relaxed));
+
+                if (cas_head_.compare_exchange_weak(
+                            old_head,
+                            TaggedPointer{next, old_head.tag + 1},
+                            std::memory_order_acquire,
+                            std::memory_order_relaxed
+                    )) {
+                    count_cas_pop(1);
+
+                    sink(std::move(old_head.pointer->value));
+                    dispose_node(old_head.pointer);
+                    return true;
+                }
+
+                note_cas_failure();
+
+                if (Node* eliminated = try_eliminate_pop()) {
+                    sink(std::move(eliminated->value));
+                    dispose_node(eliminated);
+                    return true;
+                }
+
+                old_head = cas_head_.load(std::memory_order_acquire);
+            }
+
+            return false;
+        }
+
+        template <typename OutputIt> size_t cas_pop_bulk_impl(size_t n, OutputIt out) {
+            if constexpr (k_tagged_cas) {
+                return tagged_pop_bulk_impl(n, out);
+            }
+            else if constexpr (k_unrolled_cas) {
+                return unrolled_pop_bulk_impl(n, out);
+            }
+            else {
+                return hazard_pop_bulk_impl(n, out);
+            }
+        }
+
+        // Detaches up to `n` nodes with one head CAS. The old head stays protected for the whole
+        // walk, so while cas_head_ still equals it the chain below is unchanged; `walk` keeps the
+        // current node alive between that check and reading its next pointer.
+        template <typename OutputIt> size_t hazard_pop_bulk_impl(size_t n, OutputIt out) {
+            HazardRecord* hazard(acquire_hazard());
+            Node* old_head(cas_head_.load(std::memory_order_acquire));
+            Node* last{nullptr};
+            size_t count{0};
+
+            while (old_head) {
+                hazard->pointer.store(old_head, std::memory_order_seq_cst);
+
+                if (cas_head_.load(std::memory_order_seq_cst) != old_head) {
+                    old_head = cas_head_.load(std::memory_order_acquire);
+                    continue;
+                }
+
+                bool head_moved{false};
+                last = old_head;
+                count = 1;
+
+                while (count < n) {
+                    Node* next(last->next.load(std::memory_order_relaxed));
+
+                    if (!next) {
+                        break;
+                    }
+
+                    hazard->walk.store(next, std::memory_order_seq_cst);
+
+                    if (cas_head_.load(std::memory_order_seq_cst) != old_head) {
+                        head_moved = true;
+                        break;
+                    }
+
+                    last = next;
+                    ++count;
+                }
+
+                if (!head_moved && cas_head_.compare_exchange_strong(
+                                           old_head,
+                                           last->next.load(std::memory_order_relaxed),
+                                           std::memory_order_seq_cst,
+                                           std::memory_order_relaxed
+                                   )) {
+                    break;
+                }
+
+                note_cas_failure();
+                old_head = cas_head_.load(std::memory_order_acquire);
+                last = nullptr;
+                count = 0;
+            }
+
+            hazard->walk.store(nullptr, std::memory_order_release);
+            hazard->pointer.store(nullptr, std::memory_order_release);
+
+            if (!last) {
+                return 0;
+            }
+
+            count_cas_pop(count);
+
+            Node* node(old_head);
+            const bool visited(top_may_be_visited());
+
+            for (size_t iii{0}; iii < count; ++iii) {
+                Node* next(node->next.load(std::memory_order_relaxed));
+                hand_over(node->value, visited, [&out](T&& value) {
+                    *out = std::move(value);
+                    ++out;
+                });
+                retire(hazard, node);
+                node = next;
+            }
+
+            return count;
+        }
+
+        // Walks without hazards. A walk through reused nodes can read any pooled node, but the
+        // tagged CAS only succeeds if the head, and therefore the chain below it, did not change.
+        template <typename OutputIt> size_t tagged_pop_bulk_impl(size_t n, OutputIt out) {
+            TaggedPointer old_head(cas_head_.load(std::memory_order_acquire));
+            size_t count{0};
+
+            while (old_head.pointer) {
+                Node* last(old_head.pointer);
+                Node* next(last->next.load(std::memory_order_relaxed));
+                count = 1;
+
+                for (; next && count < n; ++count) {
+                    last = next;
+                    next = last->next.load(std::memory_order_relaxed);
+                }
+
+                if (cas_head_.compare_exchange_weak(
+                            old_head,
+                            TaggedPointer{next, old_head.tag + 1},
+                            std::memory_order_acquire,
+                            std::memory_order_acquire
+                    )) {
+                    break;
+                }
+
+                note_cas_failure();
+                count = 0;
+            }
+
+            if (count == 0) {
+                return 0;
+            }
+
+            count_cas_pop(count);
+
+            Node* node(old_head.pointer);
+
+            for (size_t iii{0}; iii < count; ++iii) {
+                Node* next(node->next.load(std::memory_order_relaxed));
+                *out = std::move(node->value);
+                ++out;
+                dispose_node(node);
+                node = next;
+            }
+
+            return count;
+        }
+
+        // Runs `visitor` on the top value while its hazard is published. The hazard only keeps
+        // the node alive, so visitors also register in top_visitors_ to stop pops from moving
+        // the value out from under them; see hand_over().
+        template <typename F> bool cas_top_impl(F& visitor) const {
+            bool found{false};
+            top_visitors_.fetch_add(1, std::memory_order_seq_cst);
+
+            try {
+                if constexpr (k_unrolled_cas) {
+                    found = unrolled_top_impl(visitor);
+                }
+                else {
+                    found = list_top_impl(visitor);
+                }
+            }
+            catch (...) {
+                top_visitors_.fetch_sub(1, std::memory_order_release);
+                throw;
+            }
+
+            top_visitors_.fetch_sub(1, std::memory_order_release);
+            return found;
+        }
+
+        // Whether values just unlinked from the stack could still be read by a visitor: any of
+        // them may have been on top while a visitor that is still running looked at it. The
+        // unlinking RMW is seq_cst, so a visitor registering after this load re-validates the
+        // head and cannot reach them any more.
+        bool top_may_be_visited() const noexcept {
+            if constexpr (k_tagged_cas || !std::is_copy_constructible_v<T>) {
+                return false;
+            }
+            else {
+                return top_visitors_.load(std::memory_order_seq_cst) != 0;
+            }
+        }
+
+        // Gives a popped value to `consumer`. One a visitor may be reading is copied rather than
+        // moved and left for reclamation to destroy.
+        template <typename F> static void hand_over(T& value, bool visited, F&& consumer) {
+            if constexpr (std::is_copy_constructible_v<T>) {
+                if (visited) [[unlikely]] {
+                    std::invoke(consumer, T(std::as_const(value)));
+                    return;
+                }
+            }
+
+            std::invoke(consumer, std::move(value));
+        }
+
+        // unrolled_cas counterpart of hand_over(): the slot is destroyed right away unless a
+        // visitor may be reading it, in which case the chunk destroys it.
+        template <typename F>
+        static void take_slot(Node* chunk, size_t index, bool visited, F&& consumer) {
+            T* slot(chunk->slot(index));
+            hand_over(*slot, visited, consumer);
+
+            if (visited) {
+                chunk->lingering.fetch_or(std::uint64_t{1} << index, std::memory_order_relaxed);
+            }
+            else {
+                std::destroy_at(slot);
+            }
+        }
+
+        template <typename F> bool list_top_impl(F& visitor) const {
+            HazardRecord* hazard(acquire_hazard());
+            Node* old_head(cas_head_.load(std::memory_order_acquire));
+
+            while (old_head) {
+                hazard->pointer.store(old_head, std::memory_order_seq_cst);
+
+                if (cas_head_.load(std::memory_order_seq_cst) != old_head) {
+                    old_head = cas_head_.load(std::memory_order_acquire);
+                    continue;
+                }
+
+                visit_protected(hazard, visitor, old_head->value);
+                return true;
+            }
+
+            hazard->pointer.store(nullptr, std::memory_order_release);
+            return false;
+        }
+
+        // Clears the hazard once the visitor is done, also when it throws.
+        template <typename F>
+        static void visit_protected(HazardRecord* hazard, F& visitor, const T& value) {
+            try {
+                std::invoke(visitor, value);
+            }
+            catch (...) {
+                hazard->pointer.store(nullptr, std::memory_order_release);
+                throw;
+            }
+
+            hazard->pointer.store(nullptr, std::memory_order_release);
+        }
+
+        // unrolled_cas. A push claims the next slot of the head chunk and publishes it by bumping
+        // the count in the head; if that slot was used before or the chunk is full, it pushes a
+        // new chunk holding just its value. The hazard on a chunk is held until its slot has been
+        // written or read, because whichever thread takes the last value out retires the chunk.
+        template <typename... Args> void unrolled_emplace_impl(Args&&... args) {
+            T value(std::forward<Args>(args)...);
+            HazardRecord* hazard(acquire_hazard());
+            std::uintptr_t old_head(cas_head_.load(std::memory_order_acquire));
+
+            while (Node* chunk = pointer_of(old_head)) {
+                const size_t count(count_of(old_head));
+
+                if (count == k_chunk_slots) {
+                    break;
+                }
+
+                hazard->pointer.store(chunk, std::memory_order_seq_cst);
+
+                if (cas_head_.load(std::memory_order_seq_cst) != old_head) {
+                    old_head = cas_head_.load(std::memory_order_acquire);
+                    continue;
+                }
+
+                std::uint32_t expected(static_cast<std::uint32_t>(count));
+
+                if (!chunk->claimed.compare_exchange_strong(
+                            expected,
+                            expected + 1,
+                            std::memory_order_relaxed,
+                            std::memory_order_relaxed
+                    )) {
+                    break;
+                }
+
+                T* slot(::new (chunk->slot_address(count)) T(std::move(value)));
+
+                if (cas_head_.compare_exchange_strong(
+                            old_head,
+                            pack(chunk, count + 1),
+                            std::memory_order_seq_cst,
+                            std::memory_order_acquire
+                    )) {
+                    hazard->pointer.store(nullptr, std::memory_order_release);
+                    count_cas_push(1);
+                    return;
+                }
+
+                // Nobody can see the slot yet: take the value back and leave the slot unused.
+                value = std::move(*slot);
+                std::destroy_at(slot);
+                note_cas_failure();
+            }
+
+            hazard->pointer.store(nullptr, std::memory_order_release);
+
+            const std::uintptr_t new_head(append_to_chunks(0, std::move(value)));
+            Node* chunk(pointer_of(new_head));
+            chunk->below.store(old_head, std::memory_order_relaxed);
+
+            while (!cas_head_.compare_exchange_weak(
+                    old_head,
+                    new_head,
+                    std::memory_order_seq_cst,
+                    std::memory_order_relaxed
+            )) {
+                chunk->below.store(old_head, std::memory_order_relaxed);
+                note_cas_failure();
+            }
+
+            count_cas_push(1);
+        }
+
+        // Fills private chunks bottom first and splices them in with one head CAS. Only the top
+        // chunk can be partly filled.
+        template <typename InputIt> void unrolled_push_range_impl(InputIt first, InputIt last) {
+            std::uintptr_t top{0};
+            Node* bottom{nullptr};
+            size_t count{0};
+
+            try {
+                for (; first != last; ++first) {
+                    top = append_to_chunks(top, *first);
+                    bottom = bottom ? bottom : pointer_of(top);
+                    ++count;
+                }
+            }
+            catch (...) {
+                dispose_chunks(top);
+                throw;
+            }
+
+            if (!bottom) {
+                return;
+            }
+
+            splice_chunks(top, bottom);
+            count_cas_push(count);
+        }
+
+        // The head is read with acquire and `below` stored with release, so a walk that reaches
+        // the old head through a restored chain also sees the values pushed into it.
+        void splice_chunks(std::uintptr_t top, Node* bottom) {
+            std::uintptr_t old_head(cas_head_.load(std::memory_order_acquire));
+
+            while (true) {
+                bottom->below.store(old_head, std::memory_order_release);
+
+                if (cas_head_.compare_exchange_weak(
+                            old_head,
+                            top,
+                            std::memory_order_seq_cst,
+                            std::memory_order_acquire
+                    )) {
+                    return;
+                }
+
+                note_cas_failure();
+            }
+        }
+
+        template <typename Sink> bool unrolled_pop_impl(Sink& sink) {
+            HazardRecord* hazard(acquire_hazard());
+            std::uintptr_t old_head(cas_head_.load(std::memory_order_acquire));
+
+            while (Node* chunk = pointer_of(old_head)) {
+                hazard->pointer.store(chunk, std::memory_order_seq_cst);
+
+                if (cas_head_.load(std::memory_order_seq_cst) != old_head) {
+                    old_head = cas_head_.load(std::memory_order_acquire);
+                    continue;
+                }
+
+                const size_t count(count_of(old_head));
+                const std::uintptr_t next(
+                        count > 1 ? pack(chunk, count - 1)
+                                  : chunk->below.load(std::memory_order_relaxed)
+                );
+
+                if (cas_head_.compare_exchange_weak(
+                            old_head,
+                            next,
+                            std::memory_order_seq_cst,
+                            std::memory_order_acquire
+                    )) {
+                    count_cas_pop(1);
+
+                    take_slot(chunk, count - 1, top_may_be_visited(), sink);
+                    hazard->pointer.store(nullptr, std::memory_order_release);
+
+                    if (count == 1) {
+                        retire(hazard, chunk);
+                    }
+
+                    return true;
+                }
+
+                note_cas_failure();
+            }
+
+            hazard->pointer.store(nullptr, std::memory_order_release);
+            return false;
+        }
+
+        // Takes up to `n` values with one head CAS, walking down whole chunks under `walk` like
+        // the list version. The new head is the lowest chunk reached with its remaining values, or
+        // the chain below it when it was emptied.
+        template <typename OutputIt> size_t unrolled_pop_bulk_impl(size_t n, OutputIt out) {
+            HazardRecord* hazard(acquire_hazard());
+            std::uintptr_t old_head(cas_head_.load(std::memory_order_acquire));
+            size_t count{0};
+
+            while (Node* chunk = pointer_of(old_head)) {
+                hazard->pointer.store(chunk, std::memory_order_seq_cst);
+
+                if (cas_head_.load(std::memory_order_seq_cst) != old_head) {
+                    old_head = cas_head_.load(std::memory_order_acquire);
+                    continue;
+                }
+
+                bool head_moved{false};
+                std::uintptr_t last(old_head);
+                count = count_of(last);
+
+                while (count < n) {
+                    const std::uintptr_t below(
+                            pointer_of(last)->below.load(std::memory_order_relaxed)
+                    );
+
+                    if (!below) {
+                        break;
+                    }
+
+                    hazard->walk.store(pointer_of(below), std::memory_order_seq_cst);
+
+                    if (cas_head_.load(std::memory_order_seq_cst) != old_head) {
+                        head_moved = true;
+                        break;
+                    }
+
+                    last = below;
+                    count += count_of(last);
+                }
+
+                if (!head_moved) {
+                    const size_t left(count > n ? count - n : 0);
+                    const std::uintptr_t new_head(
+                            left ? pack(pointer_of(last), left)
+                                 : pointer_of(last)->below.load(std::memory_order_relaxed)
+                    );
+
+                    count -= left;
+
+                    if (cas_head_.compare_exchange_strong(
+                                old_head,
+                                new_head,
+                                std::memory_order_seq_cst,
+                                std::memory_order_relaxed
+                        )) {
+                        break;
+                    }
+                }
+
+                note_cas_failure();
+                old_head = cas_head_.load(std::memory_order_acquire);
+                count = 0;
+            }
+
+            if (count != 0) {
+                count_cas_pop(count);
+            }
+
+            // The lowest chunk may still be in the stack, so both hazards stay up until its values
+            // have been moved out.
+            std::uintptr_t at(old_head);
+            const bool visited(count != 0 && top_may_be_visited());
+
+            for (size_t remaining(count); remaining != 0;) {
+                Node* chunk(pointer_of(at));
+                const size_t stop(count_of(at) > remaining ? count_of(at) - remaining : 0);
+
+                for (size_t index(count_of(at)); index > stop; --index) {
+                    take_slot(chunk, index - 1, visited, [&out](T&& value) {
+                        *out = std::move(value);
+                        ++out;
+                    });
+                }
+
+                remaining -= count_of(at) - stop;
+
+                if (stop == 0) {
+                    at = chunk->below.load(std::memory_order_relaxed);
+                    retire(hazard, chunk);
+                }
+            }
+
+            hazard->walk.store(nullptr, std::memory_order_release);
+            hazard->pointer.store(nullptr, std::memory_order_release);
+            return count;
+        }
+
+        template <typename F> bool unrolled_top_impl(F& visitor) const {
+            HazardRecord* hazard(acquire_hazard());
+            std::uintptr_t old_head(cas_head_.load(std::memory_order_acquire));
+
+            while (Node* chunk = pointer_of(old_head)) {
+                hazard->pointer.store(chunk, std::memory_order_seq_cst);
+
+                if (cas_head_.load(std::memory_order_seq_cst) != old_head) {
+                    old_head = cas_head_.load(std::memory_order_acquire);
+                    continue;
+                }
+
+                visit_protected(hazard, visitor, *chunk->slot(count_of(old_head) - 1));
+                return true;
+            }
+
+            hazard->pointer.store(nullptr, std::memory_order_release);
+            return false;
+        }
+
+        // Adds a value on top of a private chain of chunks and returns the chain's new head.
+        template <typename... Args>
+        std::uintptr_t append_to_chunks(std::uintptr_t top, Args&&... args) {
+            Node* chunk(pointer_of(top));
+            size_t count(count_of(top));
+
+            if (!chunk || count == k_chunk_slots) {
+                chunk = create_chunk(top);
+                count = 0;
+            }
+
+            try {
+                ::new (chunk->slot_address(count)) T(std::forward<Args>(args)...);
+            }
+            catch (...) {
+                if (count == 0) {
+                    destroy_node(chunk);
+                }
+
+                throw;
+            }
+
+            chunk->claimed.store(static_cast<std::uint32_t>(count + 1), std::memory_order_relaxed);
+            return pack(chunk, count + 1);
+        }
+
+        // Destroys a chain of chunks no other thread can reach. Slots above a chunk's count were
+        // already emptied by whoever used them.
+        void dispose_chunks(std::uintptr_t head) noexcept {
+            while (Node* chunk = pointer_of(head)) {
+                std::destroy_n(chunk->slot(0), count_of(head));
+                head = chunk->below.load(std::memory_order_relaxed);
+                destroy_node(chunk);
+            }
+        }
+
+        // consume_all in CAS mode. The whole chain is taken with one exchange of the head (a tag
+        // bump under tagged_pointer_cas), after which it is private: pops that read the old head
+        // fail their CAS. The chain is counted off the size stripes while `mode_guard` still pins
+        // CAS mode, since a switch resets them, and the guard is dropped before the visitor runs
+        // so a long visit does not hold up a mode switch. Nodes are still retired rather than
+        // freed, since a stale reader may hold a hazard on one. If the visitor throws, the values
+        // it has not consumed, including the one it threw on, go back on top in whichever mode
+        // the stack is in by then.
+        template <typename F>
+        size_t cas_consume_impl(F& visitor, std::optional<ModeGuard>& mode_guard) {
+            head_type detached{};
+
+            if constexpr (k_tagged_cas) {
+                TaggedPointer old_head(cas_head_.load(std::memory_order_relaxed));
+
+                while (old_head.pointer && !cas_head_.compare_exchange_weak(
+                                                   old_head,
+                                                   TaggedPointer{nullptr, old_head.tag + 1},
+                                                   std::memory_order_acquire,
+                                                   std::memory_order_relaxed
+                                           )) {
+                    note_cas_failure();
+                }
+
+                detached = old_head;
+            }
+            else {
+                detached = cas_head_.exchange(head_type{}, std::memory_order_seq_cst);
+            }
+
+            const size_t total(chain_size(detached));
+            count_cas_pop(total);
+            mode_guard.reset();
+
+            if constexpr (k_unrolled_cas) {
+                consume_chunks(detached, visitor, total);
+            }
+            else {
+                consume_list(pointer_of(detached), visitor, total);
+            }
+
+            return total;
+        }
+
+        static size_t chain_size(head_type head) noexcept {
+            size_t count{0};
+
+            if constexpr (k_unrolled_cas) {
+                for (std::uintptr_t at(head); Node* chunk = pointer_of(at);
+                     at = chunk->below.load(std::memory_order_relaxed)) {
+                    count += count_of(at);
+                }
+            }
+            else {
+                for (Node* node(pointer_of(head)); node;
+                     node = node->next.load(std::memory_order_relaxed)) {
+                    ++count;
+                }
+            }
+
+            return count;
+        }
+
+        template <typename F> void consume_list(Node* node, F& visitor, size_t total) {
+            HazardRecord* hazard(acquire_hazard());
+            const bool visited(node && top_may_be_visited());
+            size_t count{0};
+
+            while (node) {
+                try {
+                    hand_over(node->value, visited, visitor);
+                }
+                catch (...) {
+                    Node* bottom(node);
+
+                    while (Node* next = bottom->next.load(std::memory_order_relaxed)) {
+                        bottom = next;
+                    }
+
+                    restore_list(node, bottom, total - count);
+                    throw;
+                }
+
+                Node* next(node->next.load(std::memory_order_relaxed));
+
+                if constexpr (k_tagged_cas) {
+                    dispose_node(node);
+                }
+                else {
+                    retire(hazard, node);
+                }
+
+                node = next;
+                ++count;
+            }
+        }
+
+        template <typename F> void consume_chunks(std::uintptr_t head, F& visitor, size_t total) {
+            HazardRecord* hazard(acquire_hazard());
+            const bool visited(head != 0 && top_may_be_visited());
+            size_t count{0};
+
+            while (Node* chunk = pointer_of(head)) {
+                for (size_t index(count_of(head)); index > 0; --index) {
+                    try {
+                        take_slot(chunk, index - 1, visited, visitor);
+                    }
+                    catch (...) {
+                        Node* bottom(chunk);
+
+                        while (Node* below =
+                                       pointer_of(bottom->below.load(std::memory_order_relaxed))) {
+                            bottom = below;
+                        }
+
+                        restore_chunks(pack(chunk, index), bottom, total - count);
+                        throw;
+                    }
+
+                    ++count;
+                }
+
+                head = chunk->below.load(std::memory_order_relaxed);
+                retire(hazard, chunk);
+            }
+        }
+
+        // Puts back the private chain `top`..`bottom` that a throwing consume_all visitor left
+        // over. The caller holds no ModeGuard, so the mode may have changed since the detach.
+        void restore_list(Node* top, Node* bottom, size_t count) {
+            ModeGuard mode_guard(*this);
+
+            if (mode_guard.using_cas()) {
+                splice_list(top, bottom);
+                count_cas_push(count);
+            }
+            else {
+                lock_spin_data();
+                SpinlockGuard guard(spin_lock_, std::adopt_lock);
+                spin_data_.reserve(spin_data_.size() + count);
+                append_list_to_spin(top);
+            }
+
+            wake_waiters(true);
+        }
+
+        void restore_chunks(std::uintptr_t top, Node* bottom, size_t count) {
+            ModeGuard mode_guard(*this);
+
+            if (mode_guard.using_cas()) {
+                splice_chunks(top, bottom);
+                count_cas_push(count);
+            }
+            else {
+                lock_spin_data();
+                SpinlockGuard guard(spin_lock_, std::adopt_lock);
+                spin_data_.reserve(spin_data_.size() + count);
+                append_chunks_to_spin(top);
+            }
+
+            wake_waiters(true);
+        }
+
+        // Vector-mode counterpart for the values, bottom first, that consume_all had not handed
+        // over. Like the CAS-mode restores, they go back on top of whatever was pushed in the
+        // meantime, pushed one by one if the stack has switched to CAS mode since.
+        void restore_spin_values(SpinStorage& values) {
+            ModeGuard mode_guard(*this);
+
+            if (mode_guard.using_cas()) {
+                for (size_t iii{0}; iii < values.size(); ++iii) {
+                    cas_emplace_impl(std::move(values[iii]));
+                }
+            }
+            else {
+                lock_spin_data();
+                SpinlockGuard guard(spin_lock_, std::adopt_lock);
+                spin_data_.reserve(spin_data_.size() + values.size());
+
+                for (size_t iii{0}; iii < values.size(); ++iii) {
+                    spin_data_.emplace_back(std::move(values[iii]));
+                }
+            }
+
+            wake_waiters(true);
+        }
+
+        // Walks the chain that hung below the head when the walk began. No node of it is freed
+        // before the walk ends and pops copy rather than move its values (see SnapshotScope), so
+        // no hazard has to be re-validated and the walk never restarts however busy the head is.
+        template <typename F> size_t cas_for_each_impl(F& visitor) const {
+            const head_type head(cas_head_.load(std::memory_order_seq_cst));
+            size_t count{0};
+
+            if constexpr (k_unrolled_cas) {
+                std::uintptr_t at(head);
+
+                while (Node* chunk = pointer_of(at)) {
+                    for (size_t index(count_of(at)); index > 0; --index) {
+                        std::invoke(visitor, std::as_const(*chunk->slot(index - 1)));
+                        ++count;
+                    }
+
+                    at = chunk->below.load(std::memory_order_acquire);
+                }
+            }
+            else {
+                for (Node* node(pointer_of(head)); node;
+                     node = node->next.load(std::memory_order_acquire)) {
+                    std::invoke(visitor, std::as_const(node->value));
+                    ++count;
+                }
+            }
+
+            return count;
+        }
+
+        // Copies at most k_snapshot_chunk values per lock hold, top first. Positions below the
+        // last chunk only change when the stack shrinks past them, so each chunk continues below
+        // the previous one or from the new top if that is lower. The visitor runs unlocked.
+        template <typename F> size_t spin_for_each_impl(F& visitor) const {
+            spin_vector chunk(domain_->get_allocator());
+            chunk.reserve(k_snapshot_chunk);
+
+            size_t end{std::numeric_limits<size_t>::max()};
+            size_t count{0};
+
+            while (end != 0) {
+                {
+                    SpinlockGuard guard(spin_lock_);
+                    end = std::min(end, spin_data_.size());
+
+                    const size_t begin(end > k_snapshot_chunk ? end - k_snapshot_chunk : 0);
+                    chunk.clear();
+
+                    for (size_t index(begin); index < end; ++index) {
+                        chunk.push_back(spin_data_[index]);
+                    }
+
+                    end = begin;
+                }
+
+                for (size_t index(chunk.size()); index > 0; --index) {
+                    std::invoke(visitor, std::as_const(chunk[index - 1]));
+                }
+
+                count += chunk.size();
+            }
+
+            return count;
+        }
+
+        bool cas_empty_impl() const noexcept {
+            return pointer_of(cas_head_.load(std::memory_order_acquire)) == nullptr;
+        }
+
+        // Stripes are read one after another, so under concurrent pushes and pops the sum may
+        // briefly undercount below zero; that is reported as empty.
+        size_t cas_size_impl() const noexcept {
+            std::ptrdiff_t total{0};
+            for (const CounterStripe& stripe : stripes_) {
+                total += stripe.count.load(std::memory_order_relaxed);
+            }
+
+            return total > 0 ? static_cast<size_t>(total) : 0;
+        }
+
+        // Unlinks the whole chain. Only valid while no operation is in flight on the stack.
+        head_type detach_cas_chain() noexcept {
+            const head_type head(cas_head_.load(std::memory_order_acquire));
+
+            if constexpr (k_unrolled_cas) {
+                cas_head_.store(0, std::memory_order_relaxed);
+            }
+            else {
+                cas_head_.store(successor(head, nullptr), std::memory_order_relaxed);
+            }
+
+            return head;
+        }
+
+        void clear_cas_nodes() {
+            if constexpr (k_unrolled_cas) {
+                dispose_chunks(detach_cas_chain());
+            }
+            else {
+                dispose_chain(pointer_of(detach_cas_chain()));
+            }
+
+            reset_cas_size(0);
+        }
+
+        void observe_contention(size_t active_now) {
+            if ((mode_.load(std::memory_order_relaxed) & k_mode_cas) != 0) {
+                if (active_now > 1) {
+                    if (quiet_streak_.load(std::memory_order_relaxed) != 0) {
+                        quiet_streak_.store(0, std::memory_order_relaxed);
+                    }
+
+                    return;
+                }
+
+                const size_t streak(quiet_streak_.fetch_add(1, std::memory_order_relaxed) + 1);
+
+                if (streak >= demotion_streak_threshold_.load(std::memory_order_relaxed)) {
+                    demotion_requested_.store(true, std::memory_order_relaxed);
+                }
+
+                return;
+            }
+
+            if (active_now >= contention_thread_threshold_.load(std::memory_order_relaxed)) {
+                const size_t streak(contention_streak_.fetch_add(1, std::memory_order_relaxed) + 1);
+
+                if (streak >= promotion_streak_threshold_.load(std::memory_order_relaxed)) {
+                    promotion_requested_.store(true, std::memory_order_relaxed);
+                }
+            }
+            else {
+                contention_streak_.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        // lock_failures detector. Failures are only counted on paths that already lost a race, and
+        // every k_contention_sample_period operations a thread reports whether its last window saw
+        // any: a clean window breaks the promotion streak, windows without CAS failures add up to
+        // a demotion.
+        void sample_operation() {
+            ContentionSample& sample(contention_sample());
+
+            if (++sample.operations < k_contention_sample_period) [[likely]] {
+                return;
+            }
+
+            const bool contended(sample.failures != 0);
+            sample = ContentionSample{.owner = this};
+
+            if ((mode_.load(std::memory_order_relaxed) & k_mode_cas) == 0) {
+                if (!contended && contention_streak_.load(std::memory_order_relaxed) != 0) {
+                    contention_streak_.store(0, std::memory_order_relaxed);
+                }
+
+                return;
+            }
+
+            if (contended) {
+                if (quiet_streak_.load(std::memory_order_relaxed) != 0) {
+                    quiet_streak_.store(0, std::memory_order_relaxed);
+                }
+
+                return;
+            }
+
+            const size_t streak(
+                    quiet_streak_.fetch_add(k_contention_sample_period, std::memory_order_relaxed) +
+                    k_contention_sample_period
+            );
+
+            if (streak >= demotion_streak_threshold_.load(std::memory_order_relaxed)) {
+                demotion_requested_.store(true, std::memory_order_relaxed);
+            }
+        }
+
+        ContentionSample& contention_sample() const noexcept {
+            ContentionSamples& local(contention_samples_);
+
+            if (local.entries[0].owner == this) [[likely]] {
+                return local.entries[0];
+            }
+
+            return contention_sample_slow(local);
+        }
+
+        ContentionSample& contention_sample_slow(ContentionSamples& local) const noexcept {
+            size_t index{1};
+
+            while (index < k_contention_sample_slots && local.entries[index].owner != this) {
+                ++index;
+            }
+
+            ContentionSample found{.owner = this};
+
+            if (index < k_contention_sample_slots) {
+                found = local.entries[index];
+            }
+            else {
+                index = k_contention_sample_slots - 1;
+            }
+
+            for (; index > 0; --index) {
+                local.entries[index] = local.entries[index - 1];
+            }
+
+            local.entries[0] = found;
+            return local.entries[0];
+        }
+
+        void note_cas_failure() noexcept {
+            stripes_[counter_stripe()].cas_failures.fetch_add(1, std::memory_order_relaxed);
+
+            if (detector_.load(std::memory_order_relaxed) == contention_detector::lock_failures) {
+                ++contention_sample().failures;
+            }
+        }
+
+        void lock_spin_data() {
+            if (spin_lock_.try_lock()) [[likely]] {
+                return;
+            }
+
+            stripes_[counter_stripe()].lock_failures.fetch_add(1, std::memory_order_relaxed);
+
+            if (detector_.load(std::memory_order_relaxed) == contention_detector::lock_failures) {
+                ++contention_sample().failures;
+                const size_t streak(contention_streak_.fetch_add(1, std::memory_order_relaxed) + 1);
+
+                if (streak >= promotion_streak_threshold_.load(std::memory_order_relaxed)) {
+                    promotion_requested_.store(true, std::memory_order_relaxed);
+                }
+            }
+
+            spin_lock_.lock();
+        }
+
+        void maybe_switch_mode() {
+            maybe_promote_to_cas();
+            maybe_demote_to_spin();
+        }
+
+        // Claims the switch from `from`, then waits until no thread is inside an operation on this
+        // stack. Callers must not hold a ModeGuard on this stack themselves.
+        bool begin_mode_switch(uint32_t from) {
+            uint32_t expected{from};
+
+            if (mode_.load(std::memory_order_relaxed) != from ||
+                snapshots_.load(std::memory_order_relaxed) != 0 ||
+                !mode_.compare_exchange_strong(
+                        expected,
+                        from | k_mode_switching,
+                        std::memory_order_seq_cst,
+                        std::memory_order_relaxed
+                )) {
+                return false;
+            }
+
+            // Records published after this load belong to threads whose announcement is ordered
+            // after the switching bit, so they back off on their own.
+            for (HazardRecord* record(domain_->records_.load(std::memory_order_seq_cst)); record;
+                 record = record->next) {
+                for (size_t spin{1}; record->active.load(std::memory_order_seq_cst) == this;
+                     ++spin) {
+                    if (spin % k_drain_spin == 0) {
+                        std::this_thread::yield();
+                    }
+                    else {
+                        cpu_relax();
+                    }
+                }
+            }
+
+            // Guards nested inside an operation on another stack announce here instead.
+            for (size_t spin{1}; nested_guards_.load(std::memory_order_seq_cst) != 0; ++spin) {
+                if (spin % k_drain_spin == 0) {
+                    std::this_thread::yield();
+                }
+                else {
+                    cpu_relax();
+                }
+            }
+
+            // A running for_each() pins the mode. It registers before it reads the mode, so either
+            // it waited for the switching bit above or this load sees it.
+            if (snapshots_.load(std::memory_order_seq_cst) != 0) {
+                end_mode_switch(from);
+                return false;
+            }
+
+            return true;
+        }
+
+        void end_mode_switch(uint32_t to) {
+            mode_.store(to, std::memory_order_release);
+            mode_.notify_all();
+        }
+
+        void maybe_promote_to_cas() {
+            if (mode_.load(std::memory_order_relaxed) != k_mode_spin ||
+                !promotion_requested_.load(std::memory_order_relaxed) ||
+                !begin_mode_switch(k_mode_spin)) {
+                return;
+            }
+
+            // Declared before the transfer so the moved-from values are released after the switch.
+            SpinStorage drained(domain_->get_allocator());
+
+            try {
+                drained = transfer_spin_to_cas();
+            }
+            catch (...) {
+                end_mode_switch(k_mode_spin);
+                throw;
+            }
+
+            quiet_streak_.store(0, std::memory_order_relaxed);
+            demotion_requested_.store(false, std::memory_order_relaxed);
+            promotions_.fetch_add(1, std::memory_order_relaxed);
+            end_mode_switch(k_mode_cas);
+        }
+
+        // Links spin_data_ bottom first into a private chain and publishes it with one store; the
+        // switch has drained all operations and the chain is empty in vector mode. Node storage
+        // comes from the node cache, so the nodes stay individually recyclable. If a node cannot
+        // be built, the values already moved go back and the stack stays in vector mode.
+        SpinStorage transfer_spin_to_cas() {
+            if constexpr (k_unrolled_cas) {
+                transfer_spin_to_chunks();
+            }
+            else {
+                transfer_spin_to_list();
+            }
+
+            reset_cas_size(spin_data_.size());
+            return std::exchange(spin_data_, SpinStorage(domain_->get_allocator()));
+        }
+
+        void transfer_spin_to_chunks() {
+            std::uintptr_t top{0};
+            size_t moved{0};
+
+            try {
+                for (; moved < spin_data_.size(); ++moved) {
+                    top = append_to_chunks(top, std::move(spin_data_[moved]));
+                }
+            }
+            catch (...) {
+                while (Node* chunk = pointer_of(top)) {
+                    for (size_t index(count_of(top)); index > 0; --index) {
+                        T* slot(chunk->slot(index - 1));
+                        spin_data_[--moved] = std::move(*slot);
+                        std::destroy_at(slot);
+                    }
+
+                    top = chunk->below.load(std::memory_order_relaxed);
+                    destroy_node(chunk);
+                }
+
+                throw;
+            }
+
+            cas_head_.store(top, std::memory_order_release);
+        }
+
+        void transfer_spin_to_list() {
+            Node* top{nullptr};
+            size_t moved{0};
+
+            try {
+                for (; moved < spin_data_.size(); ++moved) {
+                    top = make_node(top, std::move(spin_data_[moved]));
+                }
+            }
+            catch (...) {
+                while (top) {
+                    Node* next(top->next.load(std::memory_order_relaxed));
+                    spin_data_[--moved] = std::move(top->value);
+                    dispose_node(top);
+                    top = next;
+                }
+
+                throw;
+            }
+
+            cas_head_.store(
+                    successor(cas_head_.load(std::memory_order_relaxed), top),
+                    std::memory_order_release
+            );
+        }
+
+        // Rebuilds spin_data_ from the chain after a long quiet streak. In-flight operations have
+        // drained, so no thread holds a hazard on a chain node and nodes are freed directly.
+        void maybe_demote_to_spin() {
+            if (mode_.load(std::memory_order_relaxed) != k_mode_cas ||
+                !demotion_requested_.load(std::memory_order_relaxed) ||
+                !begin_mode_switch(k_mode_cas)) {
+                return;
+            }
+
+            {
+                SpinlockGuard guard(spin_lock_);
+                spin_data_.reserve(spin_data_.size() + cas_size_impl());
+
+                if constexpr (k_unrolled_cas) {
+                    move_chunks_to_spin();
+                }
+                else {
+                    move_list_to_spin();
+                }
+            }
+
+            reset_cas_size(0);
+            contention_streak_.store(0, std::memory_order_relaxed);
+            promotion_requested_.store(false, std::memory_order_relaxed);
+            demotions_.fetch_add(1, std::memory_order_relaxed);
+            end_mode_switch(k_mode_spin);
+        }
+
+        template <typename Sink> bool pop_with(Sink&& sink) {
+            ContentionScope scope(*this);
+            maybe_switch_mode();
+
+            ModeGuard mode_guard(*this);
+
+            if (mode_guard.using_cas()) {
+                return cas_pop_impl(sink);
+            }
+
+            lock_spin_data();
+            SpinlockGuard guard(spin_lock_, std::adopt_lock);
+
+            if (spin_data_.empty()) {
+                return false;
+            }
+
+            sink(std::move(spin_data_.back()));
+            spin_data_.pop_back();
+            return true;
+        }
+
+        // Blocking pops count themselves in waiters_ and sleep until push_epoch_ moves. A push
+        // bumps the epoch only when it sees a waiter, so with nobody waiting it pays one load.
+        // Pairing: a waiter registers, fences and then re-checks the stack, while a push publishes
+        // its value (a seq_cst head CAS, or a critical section on the spinlock) before loading the
+        // count. Either the push sees the waiter or the re-check sees the value. std::atomic has no
+        // timed wait, so pop_for sleeps on wait_cv_ instead, which a push only touches when
+        // timed_waiters_ is non-zero.
+        class WaiterScope {
+          public:
+            explicit WaiterScope(stack& owner, bool timed) : owner_(owner), timed_(timed) {
+                owner_.waiters_.fetch_add(1, std::memory_order_seq_cst);
 
-        struct HazardReleaser {
-            ~HazardReleaser() {
-                if (local_hazard_) {
-                    local_hazard_->pointer.store(nullptr, std::memory_order_release);
-                    local_hazard_->owner.store(std::thread::id{}, std::memory_order_release);
-                    local_hazard_ = nullptr;
+                if (timed_) {
+                    owner_.timed_waiters_.fetch_add(1, std::memory_order_seq_cst);
                 }
+
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                epoch_ = owner_.push_epoch_.load(std::memory_order_seq_cst);
             }
-        };
 
-        // 16 used as this will run on 4-threads. Reduces hazard-table scan traffic.
-        // 4 threads allows one hazard slot per active thread.
-        static constexpr size_t k_max_hazard_pointers{16};
-        static constexpr size_t k_retire_scan_threshold{64};
-        static HazardRecord hazard_records_[k_max_hazard_pointers];
-        static thread_local HazardRecord* local_hazard_;
-        static thread_local HazardReleaser hazard_releaser_;
-        static thread_local std::vector<Node*> retire_list_;
+            ~WaiterScope() {
+                if (timed_) {
+                    owner_.timed_waiters_.fetch_sub(1, std::memory_order_relaxed);
+                }
 
-        class ActiveOperationScope {
-          public:
-            explicit ActiveOperationScope(stack& stack) : stack_(stack) {
-                const size_t active_now(
-                        stack_.active_ops_.fetch_add(1, std::memory_order_relaxed) + 1
-                );
-                stack_.observe_contention(active_now);
+                owner_.waiters_.fetch_sub(1, std::memory_order_relaxed);
             }
 
-            ~ActiveOperationScope() {
-                stack_.active_ops_.fetch_sub(1, std::memory_order_relaxed);
+            WaiterScope(const WaiterScope&) = delete;
+            WaiterScope& operator=(const WaiterScope&) = delete;
+
+            // Epoch read before the re-check; a push after that point has moved it on.
+            uint32_t epoch() const noexcept {
+                return epoch_;
             }
 
           private:
-            stack& stack_;
+            stack& owner_;
+            const bool timed_;
+            uint32_t epoch_{0};
         };
 
-        static HazardRecord* acquire_hazard() {
-            if (local_hazard_) {
-                return local_hazard_;
+        void wake_waiters(bool all) {
+            if (waiters_.load(std::memory_order_seq_cst) == 0) [[likely]] {
+                return;
             }
 
-            for (size_t iii{0}; iii < k_max_hazard_pointers; ++iii) {
-                std::thread::id empty;
+            push_epoch_.fetch_add(1, std::memory_order_seq_cst);
 
-                if (hazard_records_[iii].owner.compare_exchange_strong(
-                            empty,
-                            std::this_thread::get_id(),
-                            std::memory_order_acq_rel
-                    )) {
-                    (void)hazard_releaser_;
-                    local_hazard_ = &hazard_records_[iii];
-
-                    return local_hazard_;
-                }
+            if (all) {
+                push_epoch_.notify_all();
+            }
+            else {
+                push_epoch_.notify_one();
             }
 
-            std::terminate();
+            if (timed_waiters_.load(std::memory_order_seq_cst) != 0) {
+                // Taking the lock orders the epoch bump against a timed waiter that checked the
+                // epoch but has not started waiting yet.
+                { std::lock_guard<std::mutex> guard(wait_lock_); }
+                wait_cv_.notify_all();
+            }
         }
 
-        static void scan() {
-            std::array<Node*, k_max_hazard_pointers> hazard_snapshot{};
-
-            for (size_t iii{0}; iii < k_max_hazard_pointers; ++iii) {
-                hazard_snapshot[iii] = hazard_records_[iii].pointer.load(std::memory_order_acquire);
+        // Registers a for_each() for its lifetime: as a top visitor, so pops copy the values it
+        // may be reading; with the domain, so scans free no node it may still reach; and with the
+        // stack, so the mode cannot switch under it.
+        class SnapshotScope {
+          public:
+            explicit SnapshotScope(const stack& owner) : owner_(owner) {
+                owner_.snapshots_.fetch_add(1, std::memory_order_seq_cst);
+                owner_.domain_->walkers_.fetch_add(1, std::memory_order_seq_cst);
+                owner_.top_visitors_.fetch_add(1, std::memory_order_seq_cst);
             }
 
-            size_t write_index{0};
-
-            for (size_t read_index{0}; read_index < retire_list_.size(); ++read_index) {
-                Node* retired_node(retire_list_[read_index]);
-                bool keep_node{false};
+            ~SnapshotScope() {
+                owner_.top_visitors_.fetch_sub(1, std::memory_order_release);
+                owner_.domain_->walkers_.fetch_sub(1, std::memory_order_release);
+                owner_.snapshots_.fetch_sub(1, std::memory_order_release);
+            }
 
-                for (Node* hazard_node : hazard_snapshot) {
-                    if (hazard_node == retired_node) {
-                        keep_node = true;
-                        break;
-                    }
-                }
+            SnapshotScope(const SnapshotScope&) = delete;
+            SnapshotScope& operator=(const SnapshotScope&) = delete;
 
-                if (keep_node) {
-                    retire_list_[write_index++] = retired_node;
-                }
-                else {
-                    delete retired_node;
-                }
-            }
+          private:
+            const stack& owner_;
+        };
 
-            retire_list_.resize(write_index);
+        void move_list_to_spin() {
+            append_list_to_spin(pointer_of(detach_cas_chain()));
         }
 
-        static void retire(Node* node) {
-            retire_list_.push_back(node);
-
-            if (retire_list_.size() >= k_retire_scan_threshold) {
-                scan();
-            }
+        void move_chunks_to_spin() {
+            append_chunks_to_spin(detach_cas_chain());
         }
 
-        template <typename... Args> void cas_emplace_impl(Args&&... args) {
-            Node* new_node(new Node(nullptr, std::forward<Args>(args)...));
-            Node* old_head(cas_head_.load(std::memory_order_relaxed));
+        // Both take a chain no other thread can reach and reverse it in place, so values are
+        // appended bottom first.
+        void append_list_to_spin(Node* node) {
+            Node* reversed{nullptr};
 
-            do {
-                new_node->next = old_head;
-            } while (!cas_head_.compare_exchange_weak(
-                    old_head,
-                    new_node,
-                    std::memory_order_release,
-                    std::memory_order_relaxed
-            ));
+            while (node) {
+                Node* next(node->next.load(std::memory_order_relaxed));
+                node->next.store(reversed, std::memory_order_relaxed);
+                reversed = node;
+                node = next;
+            }
 
-            cas_size_.fetch_add(1, std::memory_order_relaxed);
+            while (reversed) {
+                Node* next(reversed->next.load(std::memory_order_relaxed));
+                spin_data_.emplace_back(std::move(reversed->value));
+                dispose_node(reversed);
+                reversed = next;
+            }
         }
 
-        std::optional<T> cas_pop_impl() {
-            HazardRecord* hazard(acquire_hazard());
-            Node* old_head(cas_head_.load(std::memory_order_acquire));
+        // A reversed link keeps the packed head that pointed down to its chunk, so the count of
+        // each chunk travels with the link that reaches it.
+        void append_chunks_to_spin(std::uintptr_t node) {
+            std::uintptr_t reversed{0};
 
-            while (old_head) {
-                hazard->pointer.store(old_head, std::memory_order_release);
+            while (Node* chunk = pointer_of(node)) {
+                const std::uintptr_t below(chunk->below.load(std::memory_order_relaxed));
+                chunk->below.store(reversed, std::memory_order_relaxed);
+                reversed = node;
+                node = below;
+            }
 
-                if (cas_head_.load(std::memory_order_acquire) != old_head) {
-                    old_head = cas_head_.load(std::memory_order_acquire);
-                    continue;
+            while (Node* chunk = pointer_of(reversed)) {
+                for (size_t index{0}; index < count_of(reversed); ++index) {
+                    T* slot(chunk->slot(index));
+                    spin_data_.emplace_back(std::move(*slot));
+                    std::destroy_at(slot);
                 }
 
-                Node* next = old_head->next;
+                reversed = chunk->below.load(std::memory_order_relaxed);
+                destroy_node(chunk);
+            }
+        }
 
-                if (cas_head_.compare_exchange_weak(
-                            old_head,
-                            next,
-                            std::memory_order_acquire,
-                            std::memory_order_relaxed
-                    )) {
-                    hazard->pointer.store(nullptr, std::memory_order_release);
-                    cas_size_.fetch_sub(1, std::memory_order_relaxed);
+        std::shared_ptr<hazard_domain> domain_;
 
-                    std::optional<T> result(std::move(old_head->value));
-                    retire(old_head);
-                    return result;
-                }
-            }
+        mutable Lock spin_lock_;
+        SpinStorage spin_data_{domain_->get_allocator()};
 
-            hazard->pointer.store(nullptr, std::memory_order_release);
-            return std::nullopt;
-        }
+        std::atomic<head_type> cas_head_{};
+        std::array<CounterStripe, k_counter_stripes> stripes_{};
+        mutable std::atomic<size_t> top_visitors_{0};
+        mutable std::atomic<size_t> snapshots_{0};
+        mutable std::atomic<size_t> nested_guards_{0};
+        std::array<EliminationSlot, k_elimination_slots> elimination_slots_{};
+        std::atomic<uint32_t> mode_{k_mode_spin};
 
-        std::optional<T> cas_top_impl() const {
-            HazardRecord* hazard(acquire_hazard());
-            Node* old_head(cas_head_.load(std::memory_order_acquire));
+        // Read with relaxed loads on every decision, so set_promotion_policy() takes effect on
+        // the next operation of each thread.
+        std::atomic<contention_detector> detector_{k_default_policy.detector};
+        std::atomic<size_t> contention_thread_threshold_{k_default_policy.thread_threshold};
+        std::atomic<size_t> promotion_streak_threshold_{k_default_policy.promotion_streak};
+        std::atomic<size_t> demotion_streak_threshold_{k_default_policy.demotion_streak};
+        std::atomic<size_t> promotions_{0};
+        std::atomic<size_t> demotions_{0};
 
-            while (old_head) {
-                hazard->pointer.store(old_head, std::memory_order_release);
+        std::atomic<size_t> active_ops_{0};
+        std::atomic<size_t> contention_streak_{0};
+        std::atomic<bool> promotion_requested_{false};
+        std::atomic<size_t> quiet_streak_{0};
+        std::atomic<bool> demotion_requested_{false};
 
-                if (cas_head_.load(std::memory_order_acquire) != old_head) {
-                    old_head = cas_head_.load(std::memory_order_acquire);
-                    continue;
-                }
+        std::atomic<uint32_t> push_epoch_{0};
+        std::atomic<uint32_t> waiters_{0};
+        std::atomic<uint32_t> timed_waiters_{0};
+        std::mutex wait_lock_;
+        std::condition_variable wait_cv_;
 
-                std::optional<T> result(old_head->value);
-                hazard->pointer.store(nullptr, std::memory_order_release);
-                return result;
-            }
+      public:
+        // Owns the hazard records and retired nodes of the stacks that use it. Every stack creates
+        // its own domain unless one is passed in; stacks that share a domain also share records,
+        // which keeps per-thread state small when one thread works on many stacks.
+        class hazard_domain {
+          public:
+            hazard_domain() : id_(next_domain_id_.fetch_add(1, std::memory_order_relaxed)) {}
 
-            hazard->pointer.store(nullptr, std::memory_order_release);
-            return std::nullopt;
-        }
+            // Node storage of every stack in the domain comes from `allocator`.
+            explicit hazard_domain(const Allocator& allocator)
+                : id_(next_domain_id_.fetch_add(1, std::memory_order_relaxed)),
+                  node_allocator_(allocator) {}
 
-        bool cas_empty_impl() const noexcept {
-            return cas_head_.load(std::memory_order_acquire) == nullptr;
-        }
+            ~hazard_domain() {
+                deallocate_free_nodes(pool_);
 
-        size_t cas_size_impl() const noexcept {
-            return cas_size_.load(std::memory_order_relaxed);
-        }
+                HazardRecord* record(records_.load(std::memory_order_acquire));
 
-        void clear_cas_nodes() {
-            Node* node(cas_head_.load(std::memory_order_relaxed));
+                while (record) {
+                    HazardRecord* next(record->next);
+                    uint32_t expected{k_record_owned};
 
-            while (node) {
-                Node* next = node->next;
-                delete node;
-                node = next;
+                    for (Node* node : record->retired) {
+                        destroy_node(node);
+                    }
+                    record->retired.clear();
+
+                    deallocate_free_nodes(record->free_nodes);
+                    record->free_nodes = nullptr;
+                    record->free_count = 0;
+
+                    // A thread that still caches the record frees it when it lets go.
+                    if (!record->state.compare_exchange_strong(
+                                expected,
+                                k_record_orphaned,
+                                std::memory_order_acq_rel,
+                                std::memory_order_acquire
+                        )) {
+                        delete record;
+                    }
+
+                    record = next;
+                }
             }
 
-            cas_head_.store(nullptr, std::memory_order_relaxed);
-            cas_size_.store(0, std::memory_order_relaxed);
-        }
+            hazard_domain(const hazard_domain&) = delete;
+            hazard_domain& operator=(const hazard_domain&) = delete;
 
-        void observe_contention(size_t active_now) {
-            if (using_cas_.load(std::memory_order_relaxed)) {
-                return;
+            // Bounded by the peak number of threads that used the domain at the same time.
+            size_t record_count() const noexcept {
+                return record_count_.load(std::memory_order_relaxed);
             }
 
-            if (active_now >= contention_thread_threshold_) {
-                const size_t streak(contention_streak_.fetch_add(1, std::memory_order_relaxed) + 1);
+            allocator_type get_allocator() const noexcept {
+                return allocator_type(node_allocator_);
+            }
 
-                if (streak >= promotion_streak_threshold_) {
-                    promotion_requested_.store(true, std::memory_order_relaxed);
+          private:
+            friend class stack;
+
+            // Storage for list nodes and chunks. The default allocator goes through the node cache.
+            void* take_storage() {
+                if constexpr (k_default_allocator) {
+                    return NodeStorage::take();
+                }
+                else {
+                    return allocate_storage();
                 }
             }
-            else {
-                contention_streak_.store(0, std::memory_order_relaxed);
-            }
-        }
 
-        void maybe_promote_to_cas() {
-            if (using_cas_.load(std::memory_order_acquire) ||
-                !promotion_requested_.load(std::memory_order_relaxed)) {
-                return;
+            void recycle_storage(void* storage) noexcept {
+                if constexpr (k_default_allocator) {
+                    NodeStorage::recycle(storage);
+                }
+                else {
+                    deallocate_storage(storage);
+                }
             }
 
-            std::unique_lock mode_guard(mode_mutex_);
+            void destroy_node(Node* node) noexcept {
+                node->~Node();
+                recycle_storage(node);
+            }
 
-            if (using_cas_.load(std::memory_order_relaxed)) {
-                return;
+            // Storage that bypasses the node cache, for the tagged_pointer_cas pool.
+            void* allocate_storage() {
+                if constexpr (k_default_allocator) {
+                    return NodeStorage::allocate();
+                }
+                else {
+                    return NodeTraits::allocate(node_allocator_, 1);
+                }
             }
 
-            std::vector<T> transfer_buffer;
-            {
-                SpinlockGuard guard(spin_lock_);
-                transfer_buffer = std::move(spin_data_);
-                spin_data_.clear();
+            void deallocate_storage(void* storage) noexcept {
+                if constexpr (k_default_allocator) {
+                    NodeStorage::deallocate(storage);
+                }
+                else {
+                    NodeTraits::deallocate(node_allocator_, static_cast<Node*>(storage), 1);
+                }
             }
 
-            for (auto& value : transfer_buffer) {
-                cas_emplace_impl(std::move(value));
+            // Frees a tagged_pointer_cas free list; under the other policies lists stay empty.
+            void deallocate_free_nodes(Node* node) noexcept {
+                if constexpr (k_tagged_cas) {
+                    while (node) {
+                        Node* next(node->next.load(std::memory_order_relaxed));
+                        deallocate_storage(node);
+                        node = next;
+                    }
+                }
             }
 
-            using_cas_.store(true, std::memory_order_release);
-        }
+            HazardRecord* acquire_record() {
+                for (HazardRecord* record(records_.load(std::memory_order_acquire)); record;
+                     record = record->next) {
+                    uint32_t expected{k_record_free};
+
+                    if (record->state.load(std::memory_order_relaxed) == k_record_free &&
+                        record->state.compare_exchange_strong(
+                                expected,
+                                k_record_owned,
+                                std::memory_order_acq_rel,
+                                std::memory_order_relaxed
+                        )) {
+                        return record;
+                    }
+                }
 
-        mutable std::shared_mutex mode_mutex_;
+                HazardRecord* record(new HazardRecord());
+                HazardRecord* head(records_.load(std::memory_order_relaxed));
 
-        mutable Spinlock spin_lock_;
-        std::vector<T> spin_data_;
+                do {
+                    record->next = head;
+                } while (!records_.compare_exchange_weak(
+                        head,
+                        record,
+                        std::memory_order_release,
+                        std::memory_order_relaxed
+                ));
 
-        std::atomic<Node*> cas_head_{nullptr};
-        std::atomic<size_t> cas_size_{0};
-        std::atomic<bool> using_cas_{false};
+                record_count_.fetch_add(1, std::memory_order_relaxed);
+                return record;
+            }
 
-        const size_t contention_thread_threshold_;
-        const size_t promotion_streak_threshold_;
+            static std::atomic<std::uint64_t> next_domain_id_;
 
-        std::atomic<size_t> active_ops_{0};
-        std::atomic<size_t> contention_streak_{0};
-        std::atomic<bool> promotion_requested_{false};
+            const std::uint64_t id_;
+            [[no_unique_address]] NodeAllocator node_allocator_{};
+            std::atomic<HazardRecord*> records_{nullptr};
+            std::atomic<size_t> record_count_{0};
+            std::atomic<size_t> walkers_{0};
+
+            // tagged_pointer_cas only: free pooled nodes shared between the domain's threads,
+            // linked through `next` like the per-record free lists.
+            Spinlock pool_lock_;
+            Node* pool_{nullptr};
+        };
+
+        // Process-wide reuse counters of the CAS-mode node cache, which is shared with every
+        // container whose nodes have the same size and alignment. A hit reuses reclaimed storage;
+        // a miss goes to the global allocator.
+        using cache_stats = typename NodeStorage::stats;
 
-      public:
         stack()
-            : contention_thread_threshold_(k_default_thread_threshold),
-              promotion_streak_threshold_(k_default_streak_threshold) {}
+            : domain_(std::make_shared<hazard_domain>()) {}
+
+        // Takes both vector and node storage from `allocator`.
+        explicit stack(const Allocator& allocator)
+            : domain_(std::make_shared<hazard_domain>(allocator)) {}
 
         explicit stack(size_t reserve_hint)
-            : contention_thread_threshold_(k_default_thread_threshold),
-              promotion_streak_threshold_(k_default_streak_threshold) {
+            : domain_(std::make_shared<hazard_domain>()) {
             spin_data_.reserve(reserve_hint);
         }
 
-        stack(size_t reserve_hint, size_t contention_thread_threshold, size_t streak_threshold)
-            : contention_thread_threshold_(std::max<size_t>(2, contention_thread_threshold)),
+        // Shares `domain` with other stacks, e.g. `stack<T> other(first.domain());`.
+        explicit stack(std::shared_ptr<hazard_domain> domain)
+            : domain_(domain ? std::move(domain) : std::make_shared<hazard_domain>()) {}
+
+        explicit stack(contention_detector detector)
+            : domain_(std::make_shared<hazard_domain>()),
+              detector_(detector) {}
+
+        stack(size_t reserve_hint,
+              size_t contention_thread_threshold,
+              size_t streak_threshold,
+              std::shared_ptr<hazard_domain> domain = nullptr)
+            : stack(reserve_hint,
+                    contention_thread_threshold,
+                    streak_threshold,
+                    k_default_policy.detector,
+                    std::move(domain)) {}
+
+        // With lock_failures, `streak_threshold` counts failed lock attempts and
+        // `contention_thread_threshold` is unused.
+        stack(size_t reserve_hint,
+              size_t contention_thread_threshold,
+              size_t streak_threshold,
+              contention_detector detector,
+              std::shared_ptr<hazard_domain> domain = nullptr)
+            : domain_(domain ? std::move(domain) : std::make_shared<hazard_domain>()),
+              detector_(detector),
+              contention_thread_threshold_(std::max<size_t>(2, contention_thread_threshold)),
               promotion_streak_threshold_(std::max<size_t>(1, streak_threshold)) {
             spin_data_.reserve(reserve_hint);
         }
 
         ~stack() {
-            if (using_cas_.load(std::memory_order_acquire)) {
+            if ((mode_.load(std::memory_order_acquire) & k_mode_cas) != 0) {
                 clear_cas_nodes();
             }
         }
@@ -319,103 +2839,329 @@ namespace seraph {
         stack& operator=(const stack&) = delete;
 
         void reserve(size_t n) {
-            ActiveOperationScope scope(*this);
-            maybe_promote_to_cas();
+            ContentionScope scope(*this);
+            maybe_switch_mode();
 
-            std::shared_lock mode_guard(mode_mutex_);
-            if (using_cas_.load(std::memory_order_acquire)) {
+            ModeGuard mode_guard(*this);
+            if (mode_guard.using_cas()) {
                 return;
             }
 
-            SpinlockGuard guard(spin_lock_);
+            lock_spin_data();
+            SpinlockGuard guard(spin_lock_, std::adopt_lock);
             spin_data_.reserve(n);
         }
 
         void push(const T& value) {
-            ActiveOperationScope scope(*this);
-            maybe_promote_to_cas();
+            ContentionScope scope(*this);
+            maybe_switch_mode();
 
-            std::shared_lock mode_guard(mode_mutex_);
+            ModeGuard mode_guard(*this);
 
-            if (using_cas_.load(std::memory_order_acquire)) {
+            if (mode_guard.using_cas()) {
                 cas_emplace_impl(value);
             }
             else {
                 T temp(value);
-                SpinlockGuard guard(spin_lock_);
-                spin_data_.push_back(std::move(temp));
+                lock_spin_data();
+                SpinlockGuard guard(spin_lock_, std::adopt_lock);
+                spin_data_.emplace_back(std::move(temp));
             }
+
+            wake_waiters(false);
         }
 
         void push(T&& value) {
-            ActiveOperationScope scope(*this);
-            maybe_promote_to_cas();
+            ContentionScope scope(*this);
+            maybe_switch_mode();
 
-            std::shared_lock mode_guard(mode_mutex_);
+            ModeGuard mode_guard(*this);
 
-            if (using_cas_.load(std::memory_order_acquire)) {
+            if (mode_guard.using_cas()) {
                 cas_emplace_impl(std::move(value));
             }
             else {
-                SpinlockGuard guard(spin_lock_);
-                spin_data_.push_back(std::move(value));
+                lock_spin_data();
+                SpinlockGuard guard(spin_lock_, std::adopt_lock);
+                spin_data_.emplace_back(std::move(value));
             }
+
+            wake_waiters(false);
         }
 
         template <typename... Args> void emplace(Args&&... args) {
-            ActiveOperationScope scope(*this);
-            maybe_promote_to_cas();
+            ContentionScope scope(*this);
+            maybe_switch_mode();
 
-            std::shared_lock mode_guard(mode_mutex_);
+            ModeGuard mode_guard(*this);
 
-            if (using_cas_.load(std::memory_order_acquire)) {
+            if (mode_guard.using_cas()) {
                 cas_emplace_impl(std::forward<Args>(args)...);
             }
             else {
                 T temp(std::forward<Args>(args)...);
-                SpinlockGuard guard(spin_lock_);
-                spin_data_.push_back(std::move(temp));
+                lock_spin_data();
+                SpinlockGuard guard(spin_lock_, std::adopt_lock);
+                spin_data_.emplace_back(std::move(temp));
             }
+
+            wake_waiters(false);
         }
 
         std::optional<T> pop() {
-            ActiveOperationScope scope(*this);
-            maybe_promote_to_cas();
+            std::optional<T> result;
+
+            pop_with([&result](T&& value) {
+                result.emplace(std::move(value));
+            });
+            return result;
+        }
+
+        // Move-assigns the top value into `out`, skipping the std::optional that pop() builds.
+        // Returns false and leaves `out` untouched when the stack is empty.
+        bool try_pop(T& out) {
+            return pop_with([&out](T&& value) {
+                out = std::move(value);
+            });
+        }
 
-            std::shared_lock mode_guard(mode_mutex_);
+        // Pops the top value, sleeping on an atomic wait (a futex or ulock) while the stack is
+        // empty instead of spinning. The stack must outlive every waiter.
+        T pop_wait() {
+            std::optional<T> result;
+            auto sink([&result](T&& value) {
+                result.emplace(std::move(value));
+            });
 
-            if (using_cas_.load(std::memory_order_acquire)) {
-                return cas_pop_impl();
+            while (!pop_with(sink)) {
+                WaiterScope waiter(*this, false);
+
+                if (pop_with(sink)) {
+                    break;
+                }
+
+                push_epoch_.wait(waiter.epoch(), std::memory_order_acquire);
             }
 
-            SpinlockGuard guard(spin_lock_);
+            return std::move(*result);
+        }
 
-            if (spin_data_.empty()) {
-                return std::nullopt;
+        // Like pop_wait(), but gives up after `timeout` and then returns std::nullopt.
+        template <typename Rep, typename Period>
+        std::optional<T> pop_for(const std::chrono::duration<Rep, Period>& timeout) {
+            const auto deadline(std::chrono::steady_clock::now() + timeout);
+            std::optional<T> result;
+            auto sink([&result](T&& value) {
+                result.emplace(std::move(value));
+            });
+
+            while (!pop_with(sink)) {
+                WaiterScope waiter(*this, true);
+
+                if (pop_with(sink)) {
+                    break;
+                }
+
+                std::unique_lock<std::mutex> lock(wait_lock_);
+
+                if (!wait_cv_.wait_until(lock, deadline, [this, &waiter]() {
+                        return push_epoch_.load(std::memory_order_acquire) != waiter.epoch();
+                    })) {
+                    lock.unlock();
+                    pop_with(sink);
+                    break;
+                }
             }
 
-            std::optional<T> result(std::move(spin_data_.back()));
-            spin_data_.pop_back();
             return result;
         }
 
-        std::optional<T> top() const {
-            std::shared_lock mode_guard(mode_mutex_);
-            if (using_cas_.load(std::memory_order_acquire)) {
-                return cas_top_impl();
+        // Pushes [first, last) as one operation: one head CAS in CAS mode, one lock acquisition in
+        // vector mode. The last element ends up on top.
+        template <typename InputIt> void push_range(InputIt first, InputIt last) {
+            ContentionScope scope(*this);
+            maybe_switch_mode();
+
+            ModeGuard mode_guard(*this);
+
+            if (mode_guard.using_cas()) {
+                cas_push_range_impl(first, last);
+                wake_waiters(true);
+                return;
+            }
+
+            spin_vector batch(first, last, domain_->get_allocator());
+
+            if (batch.empty()) {
+                return;
+            }
+
+            {
+                lock_spin_data();
+                SpinlockGuard guard(spin_lock_, std::adopt_lock);
+                spin_data_.reserve(spin_data_.size() + batch.size());
+
+                for (T& value : batch) {
+                    spin_data_.emplace_back(std::move(value));
+                }
+            }
+
+            wake_waiters(true);
+        }
+
+        // Pops up to `n` values as one operation and writes them to `out` in pop order, top first.
+        // Returns the number of values written.
+        template <typename OutputIt> size_t pop_bulk(size_t n, OutputIt out) {
+            if (n == 0) {
+                return 0;
+            }
+
+            ContentionScope scope(*this);
+            maybe_switch_mode();
+
+            ModeGuard mode_guard(*this);
+
+            if (mode_guard.using_cas()) {
+                return cas_pop_bulk_impl(n, out);
+            }
+
+            spin_vector taken(domain_->get_allocator());
+            {
+                lock_spin_data();
+                SpinlockGuard guard(spin_lock_, std::adopt_lock);
+
+                const size_t count(std::min(n, spin_data_.size()));
+                taken.reserve(count);
+
+                for (size_t iii{0}; iii < count; ++iii) {
+                    taken.push_back(std::move(spin_data_.back()));
+                    spin_data_.pop_back();
+                }
+            }
+
+            for (T& value : taken) {
+                *out = std::move(value);
+                ++out;
+            }
+
+            return taken.size();
+        }
+
+        std::optional<T> top() const
+            requires(!k_tagged_cas)
+        {
+            std::optional<T> result;
+
+            top_visit([&result](const T& value) {
+                result.emplace(value);
+            });
+            return result;
+        }
+
+        // Calls `visitor(const T&)` on the top value in place instead of copying it. In CAS mode
+        // the value is hazard-protected for the duration of the call; in vector mode the spinlock
+        // is held. Returns false without calling `visitor` when the stack is empty. The visitor
+        // must not use this stack.
+        template <typename F>
+        bool top_visit(F&& visitor) const
+            requires(!k_tagged_cas && std::is_copy_constructible_v<T>)
+        {
+            ModeGuard mode_guard(*this);
+            if (mode_guard.using_cas()) {
+                return cas_top_impl(visitor);
             }
 
             SpinlockGuard guard(spin_lock_);
             if (spin_data_.empty()) {
-                return std::nullopt;
+                return false;
+            }
+
+            std::invoke(visitor, std::as_const(spin_data_.back()));
+            return true;
+        }
+
+        // Takes every value with one exchange and passes each one to `visitor` as an rvalue, top
+        // first, without further synchronization per value. Returns the number of values visited.
+        // The visitor runs outside the mode guard, so a mode switch can go ahead meanwhile. If the
+        // visitor throws, the value it threw on and those not yet consumed go back on top of the
+        // stack in their original order, above anything pushed meanwhile, in either mode. The
+        // visitor must not use this stack.
+        template <typename F> size_t consume_all(F&& visitor) {
+            ContentionScope scope(*this);
+            maybe_switch_mode();
+
+            std::optional<ModeGuard> mode_guard(std::in_place, *this);
+
+            if (mode_guard->using_cas()) {
+                return cas_consume_impl(visitor, mode_guard);
+            }
+
+            SpinStorage taken(domain_->get_allocator());
+            {
+                lock_spin_data();
+                SpinlockGuard guard(spin_lock_, std::adopt_lock);
+                taken.swap(spin_data_);
+            }
+
+            mode_guard.reset();
+            size_t remaining(taken.size());
+
+            try {
+                for (; remaining > 0; --remaining) {
+                    std::invoke(visitor, std::move(taken[remaining - 1]));
+                }
+            }
+            catch (...) {
+                while (taken.size() > remaining) {
+                    taken.pop_back();
+                }
+
+                restore_spin_values(taken);
+                throw;
+            }
+
+            return taken.size();
+        }
+
+        // Calls `visitor` with each value, top first, while pushes and pops go on. Returns the
+        // number of values visited. This is not a point-in-time snapshot. CAS mode visits the
+        // chain as it was when the call began. Vector mode copies k_snapshot_chunk values per lock
+        // hold, so values pushed or popped meanwhile may or may not be seen. Mode switches wait
+        // until the walk ends, and under hazard_pointer_cas and unrolled_cas nodes retired in
+        // the meantime are freed only afterwards, across the whole domain.
+        template <typename F>
+        size_t for_each(F&& visitor) const
+            requires(!k_tagged_cas && std::is_copy_constructible_v<T>)
+        {
+            SnapshotScope scope(*this);
+            bool using_cas{false};
+            {
+                ModeGuard mode_guard(*this);
+                using_cas = mode_guard.using_cas();
+            }
+
+            if (using_cas) {
+                return cas_for_each_impl(visitor);
             }
 
-            return spin_data_.back();
+            return spin_for_each_impl(visitor);
         }
 
-        bool empty() const noexcept {
-            std::shared_lock mode_guard(mode_mutex_);
-            if (using_cas_.load(std::memory_order_acquire)) {
+        // Copies the values to `out`, top first, with the guarantees of for_each().
+        template <typename OutputIt>
+        size_t snapshot(OutputIt out) const
+            requires(!k_tagged_cas && std::is_copy_constructible_v<T>)
+        {
+            return for_each([&out](const T& value) {
+                *out = value;
+                ++out;
+            });
+        }
+
+        // Not noexcept: the first call on a thread may allocate its hazard record.
+        bool empty() const {
+            ModeGuard mode_guard(*this);
+            if (mode_guard.using_cas()) {
                 return cas_empty_impl();
             }
 
@@ -423,9 +3169,9 @@ namespace seraph {
             return spin_data_.empty();
         }
 
-        size_t size() const noexcept {
-            std::shared_lock mode_guard(mode_mutex_);
-            if (using_cas_.load(std::memory_order_acquire)) {
+        size_t size() const {
+            ModeGuard mode_guard(*this);
+            if (mode_guard.using_cas()) {
                 return cas_size_impl();
             }
 
@@ -433,19 +3179,115 @@ namespace seraph {
             return spin_data_.size();
         }
 
+        // Sums the size stripes without announcing on the mode word or taking the lock. Only a
+        // stack that is settled in CAS mode is read this way; otherwise this is size(). The result
+        // may be stale by the operations in flight and by a mode switch that starts mid-read.
+        size_t approximate_size() const {
+            if (mode_.load(std::memory_order_acquire) == k_mode_cas) {
+                return cas_size_impl();
+            }
+
+            return size();
+        }
+
         bool is_using_cas() const noexcept {
-            return using_cas_.load(std::memory_order_acquire);
+            return (mode_.load(std::memory_order_acquire) & k_mode_cas) != 0;
+        }
+
+        promotion_policy get_promotion_policy() const noexcept {
+            return promotion_policy{
+                    .detector = detector_.load(std::memory_order_relaxed),
+                    .thread_threshold =
+                            contention_thread_threshold_.load(std::memory_order_relaxed),
+                    .promotion_streak = promotion_streak_threshold_.load(std::memory_order_relaxed),
+                    .demotion_streak = demotion_streak_threshold_.load(std::memory_order_relaxed),
+            };
+        }
+
+        // Safe while other threads use the stack. The streaks restart, so counts gathered under
+        // the old thresholds or detector do not trigger a switch under the new ones. Thresholds
+        // are clamped as in the constructor.
+        void set_promotion_policy(const promotion_policy& policy) noexcept {
+            detector_.store(policy.detector, std::memory_order_relaxed);
+            contention_thread_threshold_.store(
+                    std::max<size_t>(2, policy.thread_threshold), std::memory_order_relaxed
+            );
+            promotion_streak_threshold_.store(
+                    std::max<size_t>(1, policy.promotion_streak), std::memory_order_relaxed
+            );
+            demotion_streak_threshold_.store(
+                    std::max<size_t>(1, policy.demotion_streak), std::memory_order_relaxed
+            );
+            contention_streak_.store(0, std::memory_order_relaxed);
+            quiet_streak_.store(0, std::memory_order_relaxed);
+        }
+
+        contention_stats get_contention_stats() const noexcept {
+            contention_stats stats{
+                    .promotions = promotions_.load(std::memory_order_relaxed),
+                    .demotions = demotions_.load(std::memory_order_relaxed),
+            };
+
+            for (const CounterStripe& stripe : stripes_) {
+                stats.lock_failures += stripe.lock_failures.load(std::memory_order_relaxed);
+                stats.cas_failures += stripe.cas_failures.load(std::memory_order_relaxed);
+            }
+
+            return stats;
+        }
+
+        const std::shared_ptr<hazard_domain>& domain() const noexcept {
+            return domain_;
+        }
+
+        allocator_type get_allocator() const noexcept {
+            return domain_->get_allocator();
+        }
+
+        // Frees every retired node of this stack's domain that no hazard protects, including those
+        // left behind by threads that exited, instead of waiting for the next retire threshold.
+        // Returns the number of nodes still protected. Always 0 under tagged_pointer_cas, which
+        // retires nothing.
+        size_t reclaim() {
+            if constexpr (k_tagged_cas) {
+                return 0;
+            }
+            else {
+                HazardRecord* record(acquire_hazard());
+                scan(record);
+                return record->retired.size();
+            }
+        }
+
+        // Counters from exited threads plus the calling thread's unflushed counts.
+        static cache_stats node_cache_stats() noexcept {
+            return NodeStorage::get_stats();
         }
     };
 
-    template <typename T>
-    typename stack<T>::HazardRecord stack<T>::hazard_records_[stack<T>::k_max_hazard_pointers];
+    template <typename T, typename CasPolicy, typename Allocator, typename Lock>
+    std::atomic<std::uint64_t>
+            stack<T, CasPolicy, Allocator, Lock>::hazard_domain::next_domain_id_{1};
 
-    template <typename T>
-    thread_local typename stack<T>::HazardRecord* stack<T>::local_hazard_ = nullptr;
+    template <typename T, typename CasPolicy, typename Allocator, typename Lock>
+    thread_local typename stack<T, CasPolicy, Allocator, Lock>::LocalRecords
+            stack<T, CasPolicy, Allocator, Lock>::local_records_;
+
+    template <typename T, typename CasPolicy, typename Allocator, typename Lock>
+    thread_local std::vector<typename stack<T, CasPolicy, Allocator, Lock>::Node*>
+            stack<T, CasPolicy, Allocator, Lock>::hazard_snapshot_;
+
+    template <typename T, typename CasPolicy, typename Allocator, typename Lock>
+    thread_local size_t stack<T, CasPolicy, Allocator, Lock>::elimination_hint_{0};
+
+    template <typename T, typename CasPolicy, typename Allocator, typename Lock>
+    thread_local size_t stack<T, CasPolicy, Allocator, Lock>::counter_stripe_{0};
 
-    template <typename T> thread_local typename stack<T>::HazardReleaser stack<T>::hazard_releaser_;
+    template <typename T, typename CasPolicy, typename Allocator, typename Lock>
+    std::atomic<size_t> stack<T, CasPolicy, Allocator, Lock>::next_counter_stripe_{0};
 
-    template <typename T> thread_local std::vector<typename stack<T>::Node*> stack<T>::retire_list_;
+    template <typename T, typename CasPolicy, typename Allocator, typename Lock>
+    thread_local typename stack<T, CasPolicy, Allocator, Lock>::ContentionSamples
+            stack<T, CasPolicy, Allocator, Lock>::contention_samples_;
 
 } // namespace seraph
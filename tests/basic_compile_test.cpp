@@ -1,8 +1,12 @@
 #include "seraph/queue.hpp"
 #include "seraph/ringbuffer.hpp"
+#include "seraph/segmented_queue.hpp"
+#include "seraph/sharded_stack.hpp"
 #include "seraph/stack.hpp"
 
 #include <array>
+#include <memory_resource>
+#include <thread>
 
 int main() {
     seraph::stack<int> stack;
@@ -29,6 +33,114 @@ int main() {
         return 1;
     }
 
+    seraph::stack<int> shared_domain_stack(adaptive_stack.domain());
+    if (shared_domain_stack.domain() != adaptive_stack.domain()) {
+        return 1;
+    }
+
+    shared_domain_stack.push(30);
+    if (shared_domain_stack.pop() != 30 || adaptive_stack.pop() != 10) {
+        return 1;
+    }
+
+    std::array<int, 3> batch = {40, 41, 42};
+    adaptive_stack.push_range(batch.begin(), batch.end());
+
+    std::array<int, 4> popped = {0, 0, 0, 0};
+    if (adaptive_stack.pop_bulk(2, popped.begin()) != 2 || popped[0] != 42 || popped[1] != 41) {
+        return 1;
+    }
+
+    if (adaptive_stack.pop_bulk(popped.size(), popped.begin()) != 1 || popped[0] != 40) {
+        return 1;
+    }
+
+    int out{0};
+    adaptive_stack.push(60);
+    if (!adaptive_stack.try_pop(out) || out != 60 || adaptive_stack.try_pop(out)) {
+        return 1;
+    }
+
+    adaptive_stack.push(61);
+    adaptive_stack.push(62);
+    if (adaptive_stack.approximate_size() != 2 || adaptive_stack.size() != 2) {
+        return 1;
+    }
+
+    std::array<int, 2> copied = {0, 0};
+    if (adaptive_stack.snapshot(copied.begin()) != 2 || copied[0] != 62 || copied[1] != 61) {
+        return 1;
+    }
+
+    if (!adaptive_stack.top_visit([&out](const int& value) { out = value; }) || out != 62) {
+        return 1;
+    }
+
+    int consumed_sum{0};
+    if (adaptive_stack.consume_all([&consumed_sum](int value) {
+            consumed_sum = consumed_sum * 100 + value;
+        }) != 2 ||
+        consumed_sum != 6261 || !adaptive_stack.empty()) {
+        return 1;
+    }
+
+    if (adaptive_stack.reclaim() != 0) {
+        return 1;
+    }
+
+    seraph::promotion_policy policy(adaptive_stack.get_promotion_policy());
+    policy.promotion_streak = 0;
+    adaptive_stack.set_promotion_policy(policy);
+    if (adaptive_stack.get_promotion_policy().promotion_streak != 1 ||
+        adaptive_stack.get_contention_stats().promotions != 0) {
+        return 1;
+    }
+
+    std::pmr::monotonic_buffer_resource arena;
+    using arena_stack_type =
+            seraph::stack<int, seraph::hazard_pointer_cas, std::pmr::polymorphic_allocator<int>>;
+    arena_stack_type arena_stack{std::pmr::polymorphic_allocator<int>(&arena)};
+    arena_stack.push(70);
+    arena_stack.push(71);
+
+    if (arena_stack.get_allocator().resource() != &arena || arena_stack.pop() != 71) {
+        return 1;
+    }
+
+    seraph::sharded_stack<int> sharded(2);
+    sharded.push(50);
+    sharded.emplace(51);
+
+    if (sharded.size() != 2 || sharded.shard_count() != 2) {
+        return 1;
+    }
+
+    if (sharded.pop() != 51 || sharded.pop() != 50 || !sharded.empty()) {
+        return 1;
+    }
+
+    // A steal returns the victim's top and moves the rest of its batch to the thief's home shard,
+    // so the next pops stay local instead of stealing again from the victim.
+    std::thread([&sharded] {
+        for (int iii{0}; iii < 5; ++iii) {
+            sharded.push(60 + iii);
+        }
+    }).join();
+
+    if (sharded.pop() != 64) {
+        return 1;
+    }
+
+    for (int iii{0}; iii < 4; ++iii) {
+        if (sharded.pop() != 60 + iii) {
+            return 1;
+        }
+    }
+
+    if (!sharded.empty() || sharded.pop().has_value()) {
+        return 1;
+    }
+
     seraph::queue<int> queue;
     if (!queue.empty()) {
         return 1;
@@ -86,6 +198,40 @@ int main() {
         return 1;
     }
 
+    queue.push_range(values.begin(), values.end());
+    if (queue.pop_n(3, popped.begin()) != 3 || popped[0] != 3 || popped[1] != 4 ||
+        popped[2] != 5) {
+        return 1;
+    }
+
+    queue.push(7);
+    int drained_sum{0};
+
+    if (queue.drain([&drained_sum](int value) { drained_sum += value; }) != 2 ||
+        drained_sum != 13 || !queue.empty() || queue.pop_n(4, popped.begin()) != 0) {
+        return 1;
+    }
+
+    // Segments of two cells, so the values below span several segments.
+    seraph::segmented_queue<int, 2> segmented;
+    segmented.push(1);
+    segmented.emplace(2);
+    segmented.push_range(values.begin(), values.end());
+
+    if (segmented.size() != 2 + values.size()) {
+        return 1;
+    }
+
+    for (int expected : {1, 2, 3, 4, 5, 6}) {
+        if (segmented.pop() != expected) {
+            return 1;
+        }
+    }
+
+    if (!segmented.empty() || segmented.pop().has_value()) {
+        return 1;
+    }
+
     seraph::RingBuffer<int> ringbuffer(8);
     if (!ringbuffer.empty()) {
         return 1;
@@ -1,16 +1,25 @@
 #include "seraph/queue.hpp"
 #include "seraph/ringbuffer.hpp"
+#include "seraph/segmented_queue.hpp"
 #include "seraph/stack.hpp"
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <barrier>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <deque>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <numeric>
 #include <optional>
 #include <random>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <thread>
@@ -429,8 +438,52 @@ namespace {
         seraph::queue<int> queue_;
     };
 
-    class StackAdapter {
+    // Two-cell segments so that short histories cross segment boundaries.
+    class SegmentedQueueAdapter {
       public:
+        void push(int value) {
+            queue_.push(value);
+        }
+
+        [[nodiscard]] auto pop() -> std::optional<int> {
+            return queue_.pop();
+        }
+
+        [[nodiscard]] static auto front() -> std::optional<int> {
+            return std::nullopt;
+        }
+
+        [[nodiscard]] static auto back() -> std::optional<int> {
+            return std::nullopt;
+        }
+
+        [[nodiscard]] static auto top() -> std::optional<int> {
+            return std::nullopt;
+        }
+
+        [[nodiscard]] auto empty() -> bool {
+            return queue_.empty();
+        }
+
+        [[nodiscard]] auto size() -> size_t {
+            return queue_.size();
+        }
+
+      private:
+        seraph::segmented_queue<int, 2> queue_;
+    };
+
+    template <typename CasPolicy, typename Lock = Spinlock> class BasicStackAdapter {
+      public:
+        BasicStackAdapter() = default;
+
+        // Low thresholds promote on the first overlapping operations to exercise CAS mode.
+        BasicStackAdapter(size_t contention_thread_threshold, size_t streak_threshold)
+            : stack_(0,
+                     contention_thread_threshold,
+                     streak_threshold,
+                     seraph::contention_detector::active_operations) {}
+
         void push(int value) {
             stack_.push(value);
         }
@@ -439,8 +492,14 @@ namespace {
             return stack_.pop();
         }
 
+        // tagged_pointer_cas stacks have no top(); their suites never draw it.
         [[nodiscard]] auto top() -> std::optional<int> {
-            return stack_.top();
+            if constexpr (requires { stack_.top(); }) {
+                return stack_.top();
+            }
+            else {
+                return std::nullopt;
+            }
         }
 
         // Stack has no front/back; keep explicit stubs so shared test code compiles cleanly.
@@ -461,9 +520,15 @@ namespace {
         }
 
       private:
-        seraph::stack<int> stack_;
+        seraph::stack<int, CasPolicy, std::allocator<int>, Lock> stack_;
     };
 
+    using StackAdapter = BasicStackAdapter<seraph::hazard_pointer_cas>;
+    // No top(): the suite below only draws push and pop.
+    using TaggedStackAdapter = BasicStackAdapter<seraph::tagged_pointer_cas>;
+    using UnrolledStackAdapter = BasicStackAdapter<seraph::unrolled_cas>;
+    using McsStackAdapter = BasicStackAdapter<seraph::hazard_pointer_cas, McsLock>;
+
     class RingBufferAdapter {
       public:
         explicit RingBufferAdapter(size_t capacity) : ring_(capacity) {}
@@ -695,6 +760,923 @@ namespace {
         std::cout << "[PASS] " << suite_name << " linearizability (phased history)\n";
         return true;
     }
+
+    // Producers mix push_range batches with single emplaces while consumers mix pop_n with
+    // drain, on two queues at once so recycled nodes move between them. Every value must come
+    // out exactly once, and each consumer must see each producer's values in push order.
+    auto run_queue_batch_stress() -> bool {
+        constexpr size_t k_queue_count{2};
+        constexpr size_t k_producers{3};
+        constexpr size_t k_consumers{3};
+        constexpr int k_values_per_queue{50000};
+        constexpr int k_producer_shift{24};
+        constexpr int k_queue_shift{28};
+
+        auto encode = [](size_t queue, size_t producer, int sequence) -> int {
+            return (static_cast<int>(queue) << k_queue_shift)
+                   | (static_cast<int>(producer) << k_producer_shift) | sequence;
+        };
+
+        std::array<seraph::queue<int>, k_queue_count> queues;
+        const size_t total_values(k_queue_count * k_producers * k_values_per_queue);
+        std::atomic<size_t> consumed{0};
+        std::atomic<bool> order_ok{true};
+        std::vector<std::vector<int>> seen(k_consumers);
+        std::barrier sync_start(k_producers + k_consumers);
+        std::vector<std::thread> workers;
+        workers.reserve(k_producers + k_consumers);
+
+        for (size_t producer{0}; producer < k_producers; ++producer) {
+            workers.emplace_back([&, producer]() -> void {
+                std::mt19937 rng(static_cast<std::uint32_t>(0xB47C0000U + producer));
+                std::uniform_int_distribution<int> batch_dist(1, 8);
+                std::array<int, k_queue_count> next{};
+                std::vector<int> batch;
+                sync_start.arrive_and_wait();
+
+                for (size_t queue{0}; queue < k_queue_count;) {
+                    if (next[queue] == k_values_per_queue) {
+                        ++queue;
+                        continue;
+                    }
+                    const size_t target(rng() % k_queue_count);
+                    if (next[target] == k_values_per_queue) {
+                        continue;
+                    }
+
+                    const int count(std::min(batch_dist(rng), k_values_per_queue - next[target]));
+                    if (count == 1 || (rng() & 1U) == 0) {
+                        for (int iii{0}; iii < count; ++iii) {
+                            queues[target].emplace(encode(target, producer, next[target]++));
+                        }
+                    }
+                    else {
+                        batch.clear();
+                        for (int iii{0}; iii < count; ++iii) {
+                            batch.push_back(encode(target, producer, next[target]++));
+                        }
+                        queues[target].push_range(batch.begin(), batch.end());
+                    }
+                }
+            });
+        }
+
+        for (size_t consumer{0}; consumer < k_consumers; ++consumer) {
+            workers.emplace_back([&, consumer]() -> void {
+                std::mt19937 rng(static_cast<std::uint32_t>(0xB47D0000U + consumer));
+                std::uniform_int_distribution<size_t> batch_dist(1, 8);
+                std::array<std::array<int, k_producers>, k_queue_count> last{};
+                for (auto& row : last) {
+                    row.fill(-1);
+                }
+                std::vector<int>& mine = seen[consumer];
+                std::array<int, 8> popped{};
+
+                auto observe = [&](int value) -> void {
+                    const auto queue(static_cast<size_t>(value >> k_queue_shift));
+                    const auto producer(
+                            static_cast<size_t>((value >> k_producer_shift) & 0xF)
+                    );
+                    const int sequence(value & ((1 << k_producer_shift) - 1));
+                    if (queue >= k_queue_count || producer >= k_producers
+                        || sequence <= last[queue][producer]) {
+                        order_ok.store(false, std::memory_order_relaxed);
+                    }
+                    else {
+                        last[queue][producer] = sequence;
+                    }
+                    mine.push_back(value);
+                };
+
+                sync_start.arrive_and_wait();
+                while (consumed.load(std::memory_order_relaxed) < total_values) {
+                    const size_t queue(rng() % k_queue_count);
+                    size_t taken{0};
+                    if (rng() % 16 == 0) {
+                        taken = queues[queue].drain(observe);
+                    }
+                    else {
+                        taken = queues[queue].pop_n(batch_dist(rng), popped.begin());
+                        for (size_t iii{0}; iii < taken; ++iii) {
+                            observe(popped[iii]);
+                        }
+                    }
+                    consumed.fetch_add(taken, std::memory_order_relaxed);
+                }
+            });
+        }
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        if (!order_ok.load(std::memory_order_relaxed)) {
+            std::cerr << "Batch stress observed values out of per-producer order.\n";
+            return false;
+        }
+
+        std::vector<int> all;
+        all.reserve(total_values);
+        for (const auto& values : seen) {
+            all.insert(all.end(), values.begin(), values.end());
+        }
+        std::ranges::sort(all);
+        std::vector<int> expected;
+        expected.reserve(total_values);
+        for (size_t queue{0}; queue < k_queue_count; ++queue) {
+            for (size_t producer{0}; producer < k_producers; ++producer) {
+                for (int sequence{0}; sequence < k_values_per_queue; ++sequence) {
+                    expected.push_back(encode(queue, producer, sequence));
+                }
+            }
+        }
+        if (all != expected) {
+            std::cerr << "Batch stress lost or duplicated values.\n";
+            return false;
+        }
+
+        for (auto& queue : queues) {
+            if (!queue.empty() || queue.size() != 0) {
+                return false;
+            }
+            queue.push(42);
+            if (queue.back() != 42 || queue.pop() != 42 || !queue.empty()) {
+                std::cerr << "Batch stress left the queue unusable.\n";
+                return false;
+            }
+        }
+
+        std::cout << "[PASS] queue batch stress (push_range/emplace vs pop_n/drain)\n";
+        return true;
+    }
+
+    // Overlaps pushes and pops on two threads until the stack has promoted. The stack must use
+    // the active_operations detector with low thresholds. Leaves the stack empty.
+    template <typename Stack> void promote_to_cas(Stack& stack) {
+        auto churn = [&stack]() -> void {
+            while (!stack.is_using_cas()) {
+                stack.push(-1);
+                (void)stack.pop();
+            }
+        };
+
+        std::thread helper(churn);
+        churn();
+        helper.join();
+
+        while (stack.pop()) {}
+    }
+
+    // Drives stack<int, unrolled_cas> in CAS mode with batches whose sizes straddle the 11-slot
+    // int chunk, so chunks are split by pop_bulk, left partially filled and spliced by push_range
+    // while a reader walks them with snapshot() and top(). Every value must come out exactly
+    // once. With `interrupt_visits`, some consume_all visitors throw partway so the rest of the
+    // chain is restored; restored values land above newer pushes, so only without it must each
+    // batch, consume_all visit and snapshot list each producer's values in reverse push order.
+    auto run_unrolled_batch_stress(bool interrupt_visits) -> bool {
+        constexpr size_t k_producers{3};
+        constexpr size_t k_consumers{3};
+        constexpr int k_values_per_producer{40000};
+        constexpr int k_producer_shift{24};
+        constexpr int k_max_batch{24};
+
+        struct StopVisit {};
+
+        auto encode = [](size_t producer, int sequence) -> int {
+            return (static_cast<int>(producer) << k_producer_shift) | sequence;
+        };
+        auto reverse_push_order = [](const std::vector<int>& values) -> bool {
+            std::array<int, k_producers> last{};
+            last.fill(std::numeric_limits<int>::max());
+
+            for (const int value : values) {
+                const auto producer(static_cast<size_t>(value >> k_producer_shift));
+                const int sequence(value & ((1 << k_producer_shift) - 1));
+
+                if (producer >= k_producers || sequence >= last[producer]) {
+                    return false;
+                }
+                last[producer] = sequence;
+            }
+
+            return true;
+        };
+
+        seraph::stack<int, seraph::unrolled_cas> stack;
+        stack.set_promotion_policy({
+                .detector = seraph::contention_detector::active_operations,
+                .thread_threshold = 2,
+                .promotion_streak = 1,
+                .demotion_streak = std::numeric_limits<size_t>::max(),
+        });
+        promote_to_cas(stack);
+
+        const size_t total_values(k_producers * k_values_per_producer);
+        std::atomic<size_t> consumed{0};
+        std::atomic<bool> order_ok{true};
+        std::atomic<bool> snapshot_ok{true};
+        std::atomic<size_t> restores{0};
+        std::vector<std::vector<int>> seen(k_consumers);
+        std::barrier sync_start(k_producers + k_consumers + 1);
+        std::vector<std::thread> workers;
+        workers.reserve(k_producers + k_consumers + 1);
+
+        for (size_t producer{0}; producer < k_producers; ++producer) {
+            workers.emplace_back([&, producer]() -> void {
+                std::mt19937 rng(static_cast<std::uint32_t>(0xC4E10000U + producer));
+                std::uniform_int_distribution<int> batch_dist(1, k_max_batch);
+                std::vector<int> batch;
+                sync_start.arrive_and_wait();
+
+                for (int next{0}; next < k_values_per_producer;) {
+                    const int count(std::min(batch_dist(rng), k_values_per_producer - next));
+
+                    if (rng() % 4 == 0) {
+                        for (int iii{0}; iii < count; ++iii) {
+                            stack.push(encode(producer, next++));
+                        }
+                    }
+                    else {
+                        batch.clear();
+                        for (int iii{0}; iii < count; ++iii) {
+                            batch.push_back(encode(producer, next++));
+                        }
+                        stack.push_range(batch.begin(), batch.end());
+                    }
+                }
+            });
+        }
+
+        for (size_t consumer{0}; consumer < k_consumers; ++consumer) {
+            workers.emplace_back([&, consumer]() -> void {
+                std::mt19937 rng(static_cast<std::uint32_t>(0xC4E20000U + consumer));
+                std::uniform_int_distribution<size_t> batch_dist(1, k_max_batch);
+                std::vector<int>& mine = seen[consumer];
+                std::vector<int> taken;
+                sync_start.arrive_and_wait();
+
+                while (consumed.load(std::memory_order_relaxed) < total_values) {
+                    taken.clear();
+
+                    if (rng() % 32 == 0) {
+                        // Stops partway through, usually inside a chunk, so the rest is restored.
+                        const size_t limit(
+                                interrupt_visits ? rng() % (2 * k_max_batch) : total_values
+                        );
+
+                        try {
+                            stack.consume_all([&taken, limit](int&& value) -> void {
+                                if (taken.size() == limit) {
+                                    throw StopVisit{};
+                                }
+                                taken.push_back(value);
+                            });
+                        }
+                        catch (const StopVisit&) {
+                            restores.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+                    else {
+                        taken.resize(batch_dist(rng));
+                        taken.resize(stack.pop_bulk(taken.size(), taken.begin()));
+                    }
+
+                    if (!interrupt_visits && !reverse_push_order(taken)) {
+                        order_ok.store(false, std::memory_order_relaxed);
+                    }
+                    mine.insert(mine.end(), taken.begin(), taken.end());
+                    consumed.fetch_add(taken.size(), std::memory_order_relaxed);
+                }
+            });
+        }
+
+        workers.emplace_back([&]() -> void {
+            std::vector<int> values;
+            sync_start.arrive_and_wait();
+
+            while (consumed.load(std::memory_order_relaxed) < total_values) {
+                values.clear();
+                stack.snapshot(std::back_inserter(values));
+
+                if (!interrupt_visits && !reverse_push_order(values)) {
+                    snapshot_ok.store(false, std::memory_order_relaxed);
+                }
+
+                // Copies the top while pops go on, which leaves popped slots lingering.
+                for (int iii{0}; iii < 64; ++iii) {
+                    (void)stack.top();
+                }
+            }
+        });
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        if (!order_ok.load(std::memory_order_relaxed)) {
+            std::cerr << "Unrolled stress saw a batch out of reverse push order.\n";
+            return false;
+        }
+
+        if (!snapshot_ok.load(std::memory_order_relaxed)) {
+            std::cerr << "Unrolled stress saw a snapshot out of reverse push order.\n";
+            return false;
+        }
+
+        std::vector<int> all;
+        all.reserve(total_values);
+        for (const auto& values : seen) {
+            all.insert(all.end(), values.begin(), values.end());
+        }
+        std::ranges::sort(all);
+        std::vector<int> expected;
+        expected.reserve(total_values);
+        for (size_t producer{0}; producer < k_producers; ++producer) {
+            for (int sequence{0}; sequence < k_values_per_producer; ++sequence) {
+                expected.push_back(encode(producer, sequence));
+            }
+        }
+        if (all != expected) {
+            std::cerr << "Unrolled stress lost or duplicated values.\n";
+            return false;
+        }
+
+        if (!stack.is_using_cas() || !stack.empty() || stack.size() != 0) {
+            std::cerr << "Unrolled stress left the stack in the wrong state.\n";
+            return false;
+        }
+
+        // A partially filled top chunk under a full one, taken across the boundary.
+        std::vector<int> values(15);
+        std::iota(values.begin(), values.end(), 0);
+        stack.push_range(values.begin(), values.end());
+        std::array<int, 6> popped{};
+        if (stack.pop_bulk(popped.size(), popped.begin()) != 6 || popped[0] != 14
+            || popped[5] != 9 || stack.size() != 9 || stack.top() != 8) {
+            std::cerr << "Unrolled stress mis-split a partial chunk.\n";
+            return false;
+        }
+        stack.push(100);
+        if (stack.pop() != 100 || stack.pop() != 8 || stack.size() != 8) {
+            std::cerr << "Unrolled stress mis-filled a partial chunk.\n";
+            return false;
+        }
+        while (stack.pop()) {}
+
+        std::cout << "[PASS] stack_unrolled_cas batch stress (push_range/push vs pop_bulk/"
+                     "consume_all, snapshot/top";
+        if (interrupt_visits) {
+            std::cout << ", " << restores.load(std::memory_order_relaxed) << " restores";
+        }
+        std::cout << ")\n";
+        return true;
+    }
+
+    // Nests top_visit() across more stacks than a thread caches hazard records for, each with a
+    // domain of its own, so the inner calls push the outer records out of the cache while their
+    // announcements and hazards are live. A helper thread then pops every top and reclaims: each
+    // popped node must stay protected until its visitor returns, and every visitor must still
+    // read its own value afterwards.
+    auto run_nested_hazard_check() -> bool {
+        constexpr size_t k_depth{12};
+        using NestedStack = seraph::stack<int>;
+
+        std::vector<std::unique_ptr<NestedStack>> stacks;
+        for (size_t iii{0}; iii < k_depth; ++iii) {
+            stacks.push_back(std::make_unique<NestedStack>());
+            stacks.back()->set_promotion_policy({
+                    .detector = seraph::contention_detector::active_operations,
+                    .thread_threshold = 2,
+                    .promotion_streak = 1,
+                    .demotion_streak = std::numeric_limits<size_t>::max(),
+            });
+            promote_to_cas(*stacks.back());
+            stacks.back()->push(static_cast<int>(iii));
+        }
+
+        size_t still_protected{0};
+        bool values_ok{true};
+        std::function<void(size_t)> visit = [&](size_t depth) -> void {
+            if (depth == k_depth) {
+                std::thread([&]() -> void {
+                    for (auto& stack : stacks) {
+                        (void)stack->pop();
+                        still_protected += stack->reclaim();
+                    }
+                }).join();
+                return;
+            }
+
+            const bool found(stacks[depth]->top_visit([&](const int& value) -> void {
+                visit(depth + 1);
+                values_ok = values_ok && value == static_cast<int>(depth);
+            }));
+            values_ok = values_ok && found;
+        };
+        visit(0);
+
+        if (still_protected != k_depth || !values_ok) {
+            std::cerr << "Nested top_visit lost a hazard: " << still_protected << " of " << k_depth
+                      << " popped nodes stayed protected.\n";
+            return false;
+        }
+
+        for (auto& stack : stacks) {
+            stack->push(7);
+            if (stack->pop() != 7 || !stack->empty() || stack->reclaim() != 0) {
+                std::cerr << "Nested top_visit left a stack unusable.\n";
+                return false;
+            }
+        }
+
+        std::cout << "[PASS] nested top_visit across " << k_depth << " hazard domains\n";
+        return true;
+    }
+
+    // Waits up to `limit` for `done`, so a blocking pop that missed its wakeup fails the test
+    // instead of hanging it.
+    auto finished_within(const std::atomic<bool>& done, std::chrono::milliseconds limit) -> bool {
+        const auto deadline(std::chrono::steady_clock::now() + limit);
+
+        while (!done.load(std::memory_order_acquire)) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return true;
+    }
+
+    // Puts pop_wait() and pop_for() to sleep on an empty stack and wakes them with push,
+    // push_range, and a push after a promotion and after a demotion, then checks that pop_for
+    // gives up at its deadline in both modes.
+    auto run_blocking_pop_check() -> bool {
+        using namespace std::chrono_literals;
+        constexpr auto k_settle{20ms};
+        constexpr auto k_limit{2000ms};
+        constexpr int k_unblock{-2};
+
+        seraph::stack<int> stack;
+        stack.set_promotion_policy({
+                .detector = seraph::contention_detector::active_operations,
+                .thread_threshold = 2,
+                .promotion_streak = 1,
+                .demotion_streak = std::numeric_limits<size_t>::max(),
+        });
+
+        // Runs `pop` on `waiters` threads, gives them k_settle to fall asleep, calls `wake` and
+        // expects the popped values, in any order. Waiters skip the -1 values promote_to_cas()
+        // churns through. If they miss the wakeup they are freed with k_unblock values.
+        auto expect_wake = [&](std::string_view what,
+                               size_t waiters,
+                               auto pop,
+                               auto wake,
+                               std::vector<int> expected) -> bool {
+            std::atomic<size_t> finished{0};
+            std::atomic<bool> done{false};
+            std::vector<int> got(waiters);
+            std::vector<std::thread> threads;
+
+            for (size_t iii{0}; iii < waiters; ++iii) {
+                threads.emplace_back([&, iii]() -> void {
+                    std::optional<int> value;
+                    do {
+                        value = pop();
+                    } while (value == -1);
+                    got[iii] = value.value_or(k_unblock);
+
+                    if (finished.fetch_add(1, std::memory_order_acq_rel) + 1 == waiters) {
+                        done.store(true, std::memory_order_release);
+                    }
+                });
+            }
+
+            std::this_thread::sleep_for(k_settle);
+            wake();
+            const bool woke(finished_within(done, k_limit));
+
+            if (!woke) {
+                for (size_t iii{0}; iii < waiters; ++iii) {
+                    stack.push(k_unblock);
+                }
+            }
+
+            for (auto& thread : threads) {
+                thread.join();
+            }
+
+            std::ranges::sort(got);
+            std::ranges::sort(expected);
+            if (!woke || got != expected) {
+                std::cerr << "Blocking pop was not woken by " << what << ".\n";
+                return false;
+            }
+
+            return true;
+        };
+
+        auto wait_pop = [&stack]() -> std::optional<int> {
+            return stack.pop_wait();
+        };
+        auto timed_pop = [&stack, k_limit]() -> std::optional<int> {
+            return stack.pop_for(k_limit);
+        };
+        auto expect_timeout = [&stack, k_settle](std::string_view mode) -> bool {
+            const auto start(std::chrono::steady_clock::now());
+            const std::optional<int> value(stack.pop_for(k_settle));
+
+            if (value || std::chrono::steady_clock::now() - start < k_settle) {
+                std::cerr << "pop_for did not time out on an empty stack in " << mode
+                          << " mode.\n";
+                return false;
+            }
+
+            return true;
+        };
+
+        const bool passed(
+                expect_timeout("vector") &&
+                expect_wake("a push", 1, wait_pop, [&]() { stack.push(10); }, {10}) &&
+                expect_wake(
+                        "push_range",
+                        3,
+                        timed_pop,
+                        [&]() {
+                            const std::array<int, 3> batch{20, 21, 22};
+                            stack.push_range(batch.begin(), batch.end());
+                        },
+                        {20, 21, 22}
+                ) &&
+                expect_wake(
+                        "a push after promotion",
+                        1,
+                        wait_pop,
+                        [&]() {
+                            promote_to_cas(stack);
+                            stack.push(30);
+                        },
+                        {30}
+                ) &&
+                stack.is_using_cas() && expect_timeout("CAS") &&
+                expect_wake(
+                        "push_range in CAS mode",
+                        2,
+                        wait_pop,
+                        [&]() {
+                            const std::array<int, 2> batch{40, 41};
+                            stack.push_range(batch.begin(), batch.end());
+                        },
+                        {40, 41}
+                ) &&
+                expect_wake(
+                        "a push after demotion",
+                        1,
+                        timed_pop,
+                        [&]() {
+                            stack.set_promotion_policy({
+                                    .detector = seraph::contention_detector::active_operations,
+                                    .thread_threshold = 2,
+                                    .promotion_streak = 1,
+                                    .demotion_streak = 1,
+                            });
+                            int ignored{0};
+                            while (stack.is_using_cas()) {
+                                (void)stack.try_pop(ignored);
+                            }
+                            stack.push(50);
+                        },
+                        {50}
+                ) &&
+                !stack.is_using_cas() && stack.empty()
+        );
+
+        if (!passed) {
+            std::cerr << "Blocking pop check failed.\n";
+            return false;
+        }
+
+        std::cout << "[PASS] stack pop_wait/pop_for wakeups and timeouts across mode switches\n";
+        return true;
+    }
+
+    // Promotes, demotes and promotes a stack again by tightening its policy between phases,
+    // with two threads pushing across each switch and, in the last phase, one of them popping.
+    // After every phase the stack must hold exactly the values pushed and not popped, size()
+    // must agree, and each thread's values must sit in reverse push order; at the end single
+    // pops must return them in the order the last snapshot listed.
+    auto run_mode_cycle_check() -> bool {
+        constexpr size_t k_sources{3};
+        constexpr int k_source_shift{24};
+        constexpr int k_base_values{100};
+        constexpr int k_min_pushes{2000};
+        constexpr int k_max_pushes{2'000'000};
+        constexpr size_t k_never{std::numeric_limits<size_t>::max()};
+
+        auto encode = [](size_t source, int sequence) -> int {
+            return (static_cast<int>(source) << k_source_shift) | sequence;
+        };
+
+        seraph::stack<int> stack;
+        std::vector<int> expected;
+        std::array<int, k_sources> next{};
+
+        auto set_policy = [&stack](size_t promotion_streak, size_t demotion_streak) -> void {
+            stack.set_promotion_policy({
+                    .detector = seraph::contention_detector::active_operations,
+                    .thread_threshold = 2,
+                    .promotion_streak = promotion_streak,
+                    .demotion_streak = demotion_streak,
+            });
+        };
+
+        auto check = [&](std::string_view step, bool using_cas, std::vector<int>& values) -> bool {
+            values.clear();
+            stack.snapshot(std::back_inserter(values));
+
+            std::array<int, k_sources> last{};
+            last.fill(std::numeric_limits<int>::max());
+            bool ordered{true};
+            for (const int value : values) {
+                const auto source(static_cast<size_t>(value >> k_source_shift));
+                const int sequence(value & ((1 << k_source_shift) - 1));
+                ordered = ordered && source < k_sources && sequence < last[source];
+                last[source] = source < k_sources ? sequence : 0;
+            }
+
+            std::vector<int> sorted_values(values);
+            std::vector<int> sorted_expected(expected);
+            std::ranges::sort(sorted_values);
+            std::ranges::sort(sorted_expected);
+
+            if (stack.is_using_cas() != using_cas || !ordered || sorted_values != sorted_expected
+                || stack.size() != expected.size()) {
+                std::cerr << "Mode cycle went wrong after " << step
+                          << ": cas=" << stack.is_using_cas() << " ordered=" << ordered
+                          << " size=" << stack.size() << " expected " << expected.size() << ".\n";
+                return false;
+            }
+
+            return true;
+        };
+
+        // Sources 1 and 2 push until `switched()` holds and each has pushed k_min_pushes. With
+        // `pop`, source 2 also pops after each push.
+        auto run_phase = [&](auto switched, bool pop) -> void {
+            std::array<std::vector<int>, k_sources> pushed;
+            std::vector<int> popped;
+            std::barrier sync_start(2);
+            std::vector<std::thread> workers;
+
+            for (size_t source{1}; source < k_sources; ++source) {
+                workers.emplace_back([&, source]() -> void {
+                    sync_start.arrive_and_wait();
+
+                    for (int pushes{0};
+                         pushes < k_max_pushes && (pushes < k_min_pushes || !switched());
+                         ++pushes) {
+                        const int value(encode(source, next[source]++));
+                        stack.push(value);
+                        pushed[source].push_back(value);
+
+                        if (pop && source == 2) {
+                            if (std::optional<int> value = stack.pop()) {
+                                popped.push_back(*value);
+                            }
+                        }
+                    }
+                });
+            }
+
+            for (auto& worker : workers) {
+                worker.join();
+            }
+
+            for (const auto& values : pushed) {
+                expected.insert(expected.end(), values.begin(), values.end());
+            }
+            for (const int value : popped) {
+                expected.erase(std::ranges::find(expected, value));
+            }
+        };
+
+        auto using_cas = [&stack]() -> bool {
+            return stack.is_using_cas();
+        };
+        auto using_vector = [&stack]() -> bool {
+            return !stack.is_using_cas();
+        };
+
+        std::vector<int> values;
+        set_policy(k_never, k_never);
+        for (int iii{0}; iii < k_base_values; ++iii) {
+            stack.push(encode(0, next[0]++));
+            expected.push_back(encode(0, next[0] - 1));
+        }
+        if (!check("the base pushes", false, values)) {
+            return false;
+        }
+
+        set_policy(1, k_never);
+        run_phase(using_cas, false);
+        if (!check("promotion", true, values)) {
+            return false;
+        }
+
+        set_policy(k_never, 1);
+        run_phase(using_vector, false);
+        if (!check("demotion", false, values)) {
+            return false;
+        }
+
+        set_policy(1, k_never);
+        run_phase(using_cas, true);
+        if (!check("the second promotion", true, values)) {
+            return false;
+        }
+
+        const seraph::contention_stats stats(stack.get_contention_stats());
+        if (stats.promotions != 2 || stats.demotions != 1) {
+            std::cerr << "Mode cycle switched " << stats.promotions << " up and " << stats.demotions
+                      << " down instead of 2 and 1.\n";
+            return false;
+        }
+
+        for (size_t iii{0}; iii < values.size(); ++iii) {
+            if (stack.pop() != values[iii] || stack.size() != values.size() - iii - 1) {
+                std::cerr << "Mode cycle pops left LIFO order at " << iii << ".\n";
+                return false;
+            }
+        }
+
+        std::cout << "[PASS] stack promote/demote/promote cycle with concurrent pushes and pops\n";
+        return true;
+    }
+
+    // Has a consume_all visitor throw after another thread pushed a marker, then expects the
+    // value it threw on and the unvisited ones back on top of the marker in their original order.
+    template <typename Stack>
+    auto check_restore_order(std::string_view name, bool using_cas) -> bool {
+        constexpr int k_values{30};
+        constexpr int k_visited{10};
+        constexpr int k_marker{1000};
+        Stack stack;
+
+        if (using_cas) {
+            stack.set_promotion_policy({
+                    .detector = seraph::contention_detector::active_operations,
+                    .thread_threshold = 2,
+                    .promotion_streak = 1,
+                    .demotion_streak = std::numeric_limits<size_t>::max(),
+            });
+            promote_to_cas(stack);
+        }
+
+        for (int iii{0}; iii < k_values; ++iii) {
+            stack.push(iii);
+        }
+
+        int visited{0};
+        try {
+            stack.consume_all([&stack, &visited](int&&) -> void {
+                if (++visited > k_visited) {
+                    std::thread([&stack]() -> void { stack.push(int{k_marker}); }).join();
+                    throw std::runtime_error("interrupted visit");
+                }
+            });
+        }
+        catch (const std::runtime_error&) {}
+
+        std::vector<int> expected(k_values - k_visited);
+        std::iota(expected.rbegin(), expected.rend(), 0);
+        expected.push_back(k_marker);
+
+        std::vector<int> popped;
+        while (std::optional<int> value = stack.pop()) {
+            popped.push_back(*value);
+        }
+
+        if (stack.is_using_cas() != using_cas || popped != expected) {
+            std::cerr << name << " restored " << popped.size() << " values out of order.\n";
+            return false;
+        }
+
+        return true;
+    }
+
+    auto run_restore_order_check() -> bool {
+        if (!check_restore_order<seraph::stack<int>>("Vector-mode consume_all", false)
+            || !check_restore_order<seraph::stack<int>>("CAS-mode consume_all", true)
+            || !check_restore_order<seraph::stack<int, seraph::unrolled_cas>>(
+                    "Unrolled consume_all", true
+            )) {
+            return false;
+        }
+
+        std::cout << "[PASS] stack consume_all restores above intervening pushes in both modes\n";
+        return true;
+    }
+
+    // Two threads each hold twelve McsLocks at once, more than a thread has queue nodes, so the
+    // last locks go through their overflow nodes while a third thread queues on them normally
+    // and tries them. Each lock guards a plain counter; TSan checks the exclusion.
+    auto run_mcs_nesting_check() -> bool {
+        constexpr size_t k_locks{12};
+        constexpr size_t k_rounds{20'000};
+        std::array<McsLock, k_locks> locks;
+        std::array<size_t, k_locks> counters{};
+        std::barrier sync_start(3);
+
+        auto nest = [&]() -> void {
+            sync_start.arrive_and_wait();
+
+            for (size_t round{0}; round < k_rounds; ++round) {
+                for (McsLock& lock : locks) {
+                    lock.lock();
+                }
+                for (size_t& counter : counters) {
+                    ++counter;
+                }
+                for (size_t iii{k_locks}; iii > 0; --iii) {
+                    locks[iii - 1].unlock();
+                }
+            }
+        };
+
+        std::thread first(nest);
+        std::thread second(nest);
+        size_t single_locks{0};
+        sync_start.arrive_and_wait();
+
+        for (size_t round{0}; round < k_rounds; ++round) {
+            McsLock& lock(locks[k_locks - 1 - round % 4]);
+
+            if (round % 2 == 0) {
+                lock.lock();
+            }
+            else if (!lock.try_lock()) {
+                continue;
+            }
+
+            ++counters[k_locks - 1 - round % 4];
+            ++single_locks;
+            lock.unlock();
+        }
+
+        first.join();
+        second.join();
+
+        size_t total(std::accumulate(counters.begin(), counters.end(), size_t{0}));
+        if (total != 2 * k_rounds * k_locks + single_locks) {
+            std::cerr << "Nested McsLocks lost " << 2 * k_rounds * k_locks + single_locks - total
+                      << " increments.\n";
+            return false;
+        }
+
+        std::cout << "[PASS] McsLock nested past its per-thread queue nodes\n";
+        return true;
+    }
+
+    // Destroys a CAS-mode tagged_pointer_cas stack on a thread that never used its domain, so
+    // its nodes go straight to the domain's pool without a hazard record being looked up, then
+    // expects a sibling stack on the same domain to rebuild them all from that pool.
+    template <typename Stack> auto run_pooled_release_check() -> bool {
+        constexpr int k_values{1000};
+        auto domain(std::make_shared<typename Stack::hazard_domain>());
+        auto dropped(std::make_unique<Stack>(domain));
+        Stack kept(domain);
+
+        for (Stack* stack : {dropped.get(), &kept}) {
+            stack->set_promotion_policy({
+                    .detector = seraph::contention_detector::active_operations,
+                    .thread_threshold = 2,
+                    .promotion_streak = 1,
+                    .demotion_streak = std::numeric_limits<size_t>::max(),
+            });
+            promote_to_cas(*stack);
+        }
+
+        for (int iii{0}; iii < k_values; ++iii) {
+            dropped->push(iii);
+        }
+
+        const size_t records(domain->record_count());
+        std::thread([&dropped]() -> void { dropped.reset(); }).join();
+        const size_t misses(Stack::node_cache_stats().misses);
+
+        for (int iii{0}; iii < k_values; ++iii) {
+            kept.push(iii);
+        }
+
+        if (domain->record_count() != records || Stack::node_cache_stats().misses != misses) {
+            std::cerr << "Pooled release took a record or lost "
+                      << Stack::node_cache_stats().misses - misses << " nodes.\n";
+            return false;
+        }
+
+        std::cout << "[PASS] stack_tagged_cas releases nodes without a hazard record\n";
+        return true;
+    }
 } // namespace
 
 int main(int argc, char** argv) {
@@ -760,10 +1742,105 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    if (!run_linearizability_suite<McsStackAdapter, StackSpec>(
+                "stack_mcs",
+                0xA11CE400ULL,
+                trials,
+                thread_count,
+                ops_per_thread,
+                stack_ops,
+                []() -> McsStackAdapter {
+                    return {};
+                }
+        )) {
+        return 1;
+    }
+
+    if (!run_linearizability_suite<StackAdapter, StackSpec>(
+                "stack_eager_cas",
+                0xA11CE800ULL,
+                trials,
+                thread_count,
+                ops_per_thread,
+                stack_ops,
+                []() -> StackAdapter {
+                    return {2, 1};
+                }
+        )) {
+        return 1;
+    }
+
+    if constexpr (seraph::tagged_pointer_cas_supported<int>) {
+        if (!run_linearizability_suite<TaggedStackAdapter, StackSpec>(
+                    "stack_tagged_cas",
+                    0xA11CEC00ULL,
+                    trials,
+                    thread_count,
+                    ops_per_thread,
+                    stack_ops,
+                    // Dependent, so the discarded branch never instantiates the stack.
+                    []<typename Adapter = TaggedStackAdapter>() -> Adapter {
+                        return {2, 1};
+                    }
+            )) {
+            return 1;
+        }
+
+        if (!run_pooled_release_check<seraph::stack<int, seraph::tagged_pointer_cas>>()) {
+            return 1;
+        }
+    }
+    else {
+        std::cout << "[SKIP] stack_tagged_cas: no lock-free double-width CAS on this target\n";
+    }
+
+    if (!run_linearizability_suite<UnrolledStackAdapter, StackSpec>(
+                "stack_unrolled_cas",
+                0xC4E11E00ULL,
+                trials,
+                thread_count,
+                ops_per_thread,
+                stack_ops,
+                []() -> UnrolledStackAdapter {
+                    return {2, 1};
+                }
+        )) {
+        return 1;
+    }
+
+    if (!run_unrolled_batch_stress(false) || !run_unrolled_batch_stress(true)) {
+        return 1;
+    }
+
+    if (!run_nested_hazard_check()) {
+        return 1;
+    }
+
+    if (!run_blocking_pop_check()) {
+        return 1;
+    }
+
+    if (!run_mode_cycle_check()) {
+        return 1;
+    }
+
+    if (!run_restore_order_check()) {
+        return 1;
+    }
+
+    if (!run_mcs_nesting_check()) {
+        return 1;
+    }
+
     const std::vector<OpKind> queue_ops = {
             OpKind::push,
             OpKind::pop,
     };
+    const std::vector<OpKind> queue_back_ops = {
+            OpKind::push,
+            OpKind::pop,
+            OpKind::back,
+    };
     if (!run_linearizability_suite<QueueAdapter, QueueSpec>(
                 "queue",
                 0xBEEFA000ULL,
@@ -778,6 +1855,38 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    if (!run_linearizability_suite<QueueAdapter, QueueSpec>(
+                "queue_back",
+                0xBEEFA800ULL,
+                trials,
+                thread_count,
+                ops_per_thread,
+                queue_back_ops,
+                []() -> QueueAdapter {
+                    return {};
+                }
+        )) {
+        return 1;
+    }
+
+    if (!run_linearizability_suite<SegmentedQueueAdapter, QueueSpec>(
+                "segmented_queue",
+                0xBEEFB000ULL,
+                trials,
+                thread_count,
+                ops_per_thread,
+                queue_ops,
+                []() -> SegmentedQueueAdapter {
+                    return {};
+                }
+        )) {
+        return 1;
+    }
+
+    if (!run_queue_batch_stress()) {
+        return 1;
+    }
+
     const std::vector<OpKind> ringbuffer_ops = {
             OpKind::push,
             OpKind::pop,
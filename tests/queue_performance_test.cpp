@@ -1,5 +1,6 @@
 #include "seraph/queue.hpp"
 #include "seraph/ringbuffer.hpp"
+#include "seraph/segmented_queue.hpp"
 
 #include <algorithm>
 #include <atomic>
@@ -331,13 +332,18 @@ namespace {
         });
     }
 
+    // back() on a queue holding `depth` values, so a walk from the head would show up as cost
+    // growing with depth. The queue is filled once, outside the timed region.
     template <typename QueueType>
-    auto bench_back(std::string_view impl_name, size_t iterations, int repeats)
+    auto bench_back(std::string_view impl_name, size_t depth, size_t iterations, int repeats)
             -> std::vector<BenchmarkSample> {
-        return run_samples(impl_name, "back", iterations, repeats, [iterations]() {
-            QueueType queue;
-            queue.emplace(11);
+        const std::string op_label = "back_depth" + std::to_string(depth);
+        QueueType queue;
+        for (size_t iii = 0; iii < depth; ++iii) {
+            queue.emplace(static_cast<int>(iii));
+        }
 
+        return run_samples(impl_name, op_label, iterations, repeats, [&queue, iterations]() {
             std::uint64_t local_sum = 0;
             for (size_t iii = 0; iii < iterations; ++iii) {
                 auto value = queue.back();
@@ -551,6 +557,257 @@ namespace {
         );
     }
 
+    // Half the threads only push and half only pop, so every node is freed on a different thread
+    // from the one that allocated it.
+    template <typename QueueType>
+    auto bench_mt_handoff(
+            std::string_view impl_name,
+            int thread_count,
+            size_t ops_per_thread,
+            int repeats
+    ) -> std::vector<BenchmarkSample> {
+        const int producer_count = std::max(1, thread_count / 2);
+        const size_t total_ops = 2 * static_cast<size_t>(producer_count) * ops_per_thread;
+        const std::string op_label = make_mt_simple_operation_label("handoff", thread_count);
+
+        return run_samples(
+                impl_name,
+                op_label,
+                total_ops,
+                repeats,
+                [producer_count, ops_per_thread]() {
+                    QueueType queue;
+                    std::barrier sync_start(2 * producer_count + 1);
+                    std::atomic<std::uint64_t> pop_sum{0};
+                    std::vector<std::thread> workers;
+                    workers.reserve(2 * static_cast<size_t>(producer_count));
+
+                    for (int thread_index = 0; thread_index < producer_count; ++thread_index) {
+                        workers.emplace_back([&, thread_index]() {
+                            sync_start.arrive_and_wait();
+                            for (size_t iii = 0; iii < ops_per_thread; ++iii) {
+                                queue.push(static_cast<int>(iii + static_cast<size_t>(thread_index))
+                                );
+                            }
+                        });
+                        workers.emplace_back([&]() {
+                            std::uint64_t local_sum = 0;
+                            sync_start.arrive_and_wait();
+                            for (size_t received = 0; received < ops_per_thread;) {
+                                auto value = queue.pop();
+                                if (!value.has_value()) {
+                                    std::this_thread::yield();
+                                    continue;
+                                }
+                                local_sum += static_cast<std::uint64_t>(*value);
+                                ++received;
+                            }
+                            pop_sum.fetch_add(local_sum, std::memory_order_relaxed);
+                        });
+                    }
+
+                    sync_start.arrive_and_wait();
+                    for (auto& worker : workers) {
+                        worker.join();
+                    }
+
+                    g_sink += pop_sum.load(std::memory_order_relaxed);
+                }
+        );
+    }
+
+    // Ingestion: half the threads push `batch_size` values per round, either with one push_range
+    // ("batch") or one push per value ("items"), and the other half pop them one at a time.
+    template <typename QueueType, bool UseBatchApi>
+    auto bench_mt_batched_push(
+            std::string_view impl_name,
+            int thread_count,
+            size_t ops_per_thread,
+            size_t batch_size,
+            int repeats
+    ) -> std::vector<BenchmarkSample> {
+        const int producer_count = std::max(1, thread_count / 2);
+        const size_t rounds = std::max<size_t>(1, ops_per_thread / batch_size);
+        const size_t per_producer = rounds * batch_size;
+        const size_t total_ops = 2 * static_cast<size_t>(producer_count) * per_producer;
+        const std::string op_label = make_mt_simple_operation_label(
+                (UseBatchApi ? "batch" : "items") + std::to_string(batch_size),
+                thread_count
+        );
+
+        return run_samples(
+                impl_name,
+                op_label,
+                total_ops,
+                repeats,
+                [producer_count, rounds, batch_size, per_producer]() {
+                    QueueType queue;
+                    std::barrier sync_start(2 * producer_count + 1);
+                    std::atomic<std::uint64_t> pop_sum{0};
+                    std::vector<std::thread> workers;
+                    workers.reserve(2 * static_cast<size_t>(producer_count));
+
+                    for (int thread_index = 0; thread_index < producer_count; ++thread_index) {
+                        workers.emplace_back([&, thread_index]() {
+                            std::vector<int> values(batch_size);
+                            for (size_t iii = 0; iii < batch_size; ++iii) {
+                                values[iii] = static_cast<int>(iii) + thread_index;
+                            }
+
+                            sync_start.arrive_and_wait();
+                            for (size_t round = 0; round < rounds; ++round) {
+                                if constexpr (UseBatchApi) {
+                                    queue.push_range(values.begin(), values.end());
+                                }
+                                else {
+                                    for (const int value : values) {
+                                        queue.push(value);
+                                    }
+                                }
+                            }
+                        });
+                        workers.emplace_back([&]() {
+                            std::uint64_t local_sum = 0;
+                            sync_start.arrive_and_wait();
+                            for (size_t received = 0; received < per_producer;) {
+                                auto value = queue.pop();
+                                if (!value.has_value()) {
+                                    std::this_thread::yield();
+                                    continue;
+                                }
+                                local_sum += static_cast<std::uint64_t>(*value);
+                                ++received;
+                            }
+                            pop_sum.fetch_add(local_sum, std::memory_order_relaxed);
+                        });
+                    }
+
+                    sync_start.arrive_and_wait();
+                    for (auto& worker : workers) {
+                        worker.join();
+                    }
+
+                    g_sink += pop_sum.load(std::memory_order_relaxed);
+                }
+        );
+    }
+
+    // Batch consumers: half the threads push one value at a time and the other half take up to
+    // `batch_size` values per call, either with pop_n ("pop_n") or one pop per value ("pop").
+    template <typename QueueType, bool UseBatchApi>
+    auto bench_mt_batched_pop(
+            std::string_view impl_name,
+            int thread_count,
+            size_t ops_per_thread,
+            size_t batch_size,
+            int repeats
+    ) -> std::vector<BenchmarkSample> {
+        const int producer_count = std::max(1, thread_count / 2);
+        const size_t total_ops = 2 * static_cast<size_t>(producer_count) * ops_per_thread;
+        const std::string op_label = make_mt_simple_operation_label(
+                (UseBatchApi ? "pop_n" : "pop") + std::to_string(batch_size),
+                thread_count
+        );
+
+        return run_samples(
+                impl_name,
+                op_label,
+                total_ops,
+                repeats,
+                [producer_count, ops_per_thread, batch_size]() {
+                    QueueType queue;
+                    std::barrier sync_start(2 * producer_count + 1);
+                    std::atomic<std::uint64_t> pop_sum{0};
+                    std::vector<std::thread> workers;
+                    workers.reserve(2 * static_cast<size_t>(producer_count));
+
+                    for (int thread_index = 0; thread_index < producer_count; ++thread_index) {
+                        workers.emplace_back([&, thread_index]() {
+                            sync_start.arrive_and_wait();
+                            for (size_t iii = 0; iii < ops_per_thread; ++iii) {
+                                queue.push(static_cast<int>(iii + static_cast<size_t>(thread_index))
+                                );
+                            }
+                        });
+                        workers.emplace_back([&]() {
+                            std::vector<int> taken(batch_size);
+                            std::uint64_t local_sum = 0;
+                            sync_start.arrive_and_wait();
+                            for (size_t received = 0; received < ops_per_thread;) {
+                                const size_t want = std::min(batch_size, ops_per_thread - received);
+                                size_t count = 0;
+
+                                if constexpr (UseBatchApi) {
+                                    count = queue.pop_n(want, taken.begin());
+                                }
+                                else {
+                                    for (; count < want; ++count) {
+                                        auto value = queue.pop();
+                                        if (!value.has_value()) {
+                                            break;
+                                        }
+                                        taken[count] = *value;
+                                    }
+                                }
+
+                                if (count == 0) {
+                                    std::this_thread::yield();
+                                    continue;
+                                }
+                                for (size_t iii = 0; iii < count; ++iii) {
+                                    local_sum += static_cast<std::uint64_t>(taken[iii]);
+                                }
+                                received += count;
+                            }
+                            pop_sum.fetch_add(local_sum, std::memory_order_relaxed);
+                        });
+                    }
+
+                    sync_start.arrive_and_wait();
+                    for (auto& worker : workers) {
+                        worker.join();
+                    }
+
+                    g_sink += pop_sum.load(std::memory_order_relaxed);
+                }
+        );
+    }
+
+    // Node allocator traffic of seraph::queue<int>, from the process-wide node cache counters.
+    // Operations count every push and pop a scenario issues, prefill included.
+    struct AllocationTally {
+        size_t operations = 0;
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+
+    template <typename Fn>
+    auto tally_queue_allocations(AllocationTally& tally, size_t operations, Fn&& fn)
+            -> std::vector<BenchmarkSample> {
+        const auto before = seraph::queue<int>::node_cache_stats();
+        auto samples = fn();
+        const auto after = seraph::queue<int>::node_cache_stats();
+
+        tally.operations += operations;
+        tally.hits += after.hits - before.hits;
+        tally.misses += after.misses - before.misses;
+        return samples;
+    }
+
+    void print_allocation_tally(std::string_view scenario, const AllocationTally& tally) {
+        const size_t nodes = tally.hits + tally.misses;
+        if (tally.operations == 0 || nodes == 0) {
+            return;
+        }
+
+        std::cout << "Queue node allocations (" << scenario << "): " << std::fixed
+                  << std::setprecision(4)
+                  << static_cast<double>(tally.misses) / static_cast<double>(tally.operations)
+                  << " per op, " << std::setprecision(2)
+                  << 100.0 * static_cast<double>(tally.hits) / static_cast<double>(nodes)
+                  << "% of nodes reused\n";
+    }
+
     auto build_aggregates(const std::vector<BenchmarkSample>& samples
     ) -> std::vector<BenchmarkAggregate> {
         std::vector<BenchmarkAggregate> aggregates;
@@ -1268,6 +1525,7 @@ int main(int argc, char** argv) {
     };
 
     using SeraphQueue = seraph::queue<int>;
+    using SeraphSegmentedQueue = seraph::segmented_queue<int>;
     using SeraphRingBuffer = RingBufferAdapter;
 #if SERAPH_HAS_BOOST_LOCKFREE_QUEUE
     using BoostQueue = BoostLockfreeQueueAdapter;
@@ -1300,8 +1558,10 @@ int main(int argc, char** argv) {
     append_samples(bench_front<SeraphRingBuffer>("ringbuffer", iterations, repeats));
     append_samples(bench_front<SeraphQueue>("queue", iterations, repeats));
 
-    append_samples(bench_back<SeraphRingBuffer>("ringbuffer", iterations, repeats));
-    append_samples(bench_back<SeraphQueue>("queue", iterations, repeats));
+    for (const size_t depth : {size_t{1}, size_t{1} << 10, size_t{1} << 20}) {
+        append_samples(bench_back<SeraphRingBuffer>("ringbuffer", depth, iterations, repeats));
+        append_samples(bench_back<SeraphQueue>("queue", depth, iterations, repeats));
+    }
 
     append_samples(bench_size<SeraphRingBuffer>("ringbuffer", iterations, repeats));
     append_samples(bench_size<SeraphQueue>("queue", iterations, repeats));
@@ -1315,10 +1575,11 @@ int main(int argc, char** argv) {
                  "without Boost.\n";
 #endif
 
-    // queue pop/front/back can consume two hazard slots per thread; keep thread counts
-    // bounded for reliable runs across debug/release builds.
-    const std::vector<int> contention_threads = {2, 4, 8};
+    // queue pop/front/back can consume two hazard slots per thread; 16 threads plus the prefill
+    // thread stay within the 64 hazard records per element type.
+    const std::vector<int> contention_threads = {2, 4, 8, 16};
     const std::vector<int> push_percents = {10, 20, 50, 80, 100};
+    AllocationTally contention_allocations;
     for (const int thread_count : contention_threads) {
         for (const int push_percent : push_percents) {
             append_samples(bench_contention_mix<SeraphRingBuffer>(
@@ -1328,8 +1589,23 @@ int main(int argc, char** argv) {
                     contention_ops_per_thread,
                     repeats
             ));
-            append_samples(bench_contention_mix<SeraphQueue>(
-                    "queue",
+            const size_t contention_ops =
+                    static_cast<size_t>(thread_count) * contention_ops_per_thread;
+            append_samples(tally_queue_allocations(
+                    contention_allocations,
+                    2 * contention_ops * static_cast<size_t>(repeats),
+                    [&]() {
+                        return bench_contention_mix<SeraphQueue>(
+                                "queue",
+                                thread_count,
+                                push_percent,
+                                contention_ops_per_thread,
+                                repeats
+                        );
+                    }
+            ));
+            append_samples(bench_contention_mix<SeraphSegmentedQueue>(
+                    "segmented_queue",
                     thread_count,
                     push_percent,
                     contention_ops_per_thread,
@@ -1347,6 +1623,8 @@ int main(int argc, char** argv) {
         }
     }
 
+    AllocationTally push_only_allocations;
+    AllocationTally pop_only_allocations;
     for (const int thread_count : contention_threads) {
         append_samples(bench_mt_push_only<SeraphRingBuffer>(
                 "ringbuffer",
@@ -1354,8 +1632,22 @@ int main(int argc, char** argv) {
                 specialized_ops_per_thread,
                 repeats
         ));
-        append_samples(bench_mt_push_only<SeraphQueue>(
-                "queue",
+        const size_t specialized_ops =
+                static_cast<size_t>(thread_count) * specialized_ops_per_thread;
+        append_samples(tally_queue_allocations(
+                push_only_allocations,
+                specialized_ops * static_cast<size_t>(repeats),
+                [&]() {
+                    return bench_mt_push_only<SeraphQueue>(
+                            "queue",
+                            thread_count,
+                            specialized_ops_per_thread,
+                            repeats
+                    );
+                }
+        ));
+        append_samples(bench_mt_push_only<SeraphSegmentedQueue>(
+                "segmented_queue",
                 thread_count,
                 specialized_ops_per_thread,
                 repeats
@@ -1375,8 +1667,20 @@ int main(int argc, char** argv) {
                 specialized_ops_per_thread,
                 repeats
         ));
-        append_samples(bench_mt_pop_only<SeraphQueue>(
-                "queue",
+        append_samples(tally_queue_allocations(
+                pop_only_allocations,
+                2 * specialized_ops * static_cast<size_t>(repeats),
+                [&]() {
+                    return bench_mt_pop_only<SeraphQueue>(
+                            "queue",
+                            thread_count,
+                            specialized_ops_per_thread,
+                            repeats
+                    );
+                }
+        ));
+        append_samples(bench_mt_pop_only<SeraphSegmentedQueue>(
+                "segmented_queue",
                 thread_count,
                 specialized_ops_per_thread,
                 repeats
@@ -1391,6 +1695,102 @@ int main(int argc, char** argv) {
 #endif
     }
 
+    AllocationTally handoff_allocations;
+    for (const int thread_count : contention_threads) {
+        append_samples(bench_mt_handoff<SeraphRingBuffer>(
+                "ringbuffer",
+                thread_count,
+                specialized_ops_per_thread,
+                repeats
+        ));
+        const size_t handoff_ops = static_cast<size_t>(thread_count) * specialized_ops_per_thread;
+        append_samples(tally_queue_allocations(
+                handoff_allocations,
+                handoff_ops * static_cast<size_t>(repeats),
+                [&]() {
+                    return bench_mt_handoff<SeraphQueue>(
+                            "queue",
+                            thread_count,
+                            specialized_ops_per_thread,
+                            repeats
+                    );
+                }
+        ));
+        append_samples(bench_mt_handoff<SeraphSegmentedQueue>(
+                "segmented_queue",
+                thread_count,
+                specialized_ops_per_thread,
+                repeats
+        ));
+#if SERAPH_HAS_BOOST_LOCKFREE_QUEUE
+        append_samples(bench_mt_handoff<BoostQueue>(
+                "BoostQueue",
+                thread_count,
+                specialized_ops_per_thread,
+                repeats
+        ));
+#endif
+    }
+
+    for (const int thread_count : contention_threads) {
+        for (const size_t batch_size : {size_t{32}, size_t{256}}) {
+            append_samples(bench_mt_batched_push<SeraphQueue, true>(
+                    "queue",
+                    thread_count,
+                    specialized_ops_per_thread,
+                    batch_size,
+                    repeats
+            ));
+            append_samples(bench_mt_batched_push<SeraphQueue, false>(
+                    "queue",
+                    thread_count,
+                    specialized_ops_per_thread,
+                    batch_size,
+                    repeats
+            ));
+#if SERAPH_HAS_BOOST_LOCKFREE_QUEUE
+            append_samples(bench_mt_batched_push<BoostQueue, false>(
+                    "BoostQueue",
+                    thread_count,
+                    specialized_ops_per_thread,
+                    batch_size,
+                    repeats
+            ));
+#endif
+        }
+    }
+
+    for (const int thread_count : contention_threads) {
+        append_samples(bench_mt_batched_pop<SeraphQueue, true>(
+                "queue",
+                thread_count,
+                specialized_ops_per_thread,
+                64,
+                repeats
+        ));
+        append_samples(bench_mt_batched_pop<SeraphQueue, false>(
+                "queue",
+                thread_count,
+                specialized_ops_per_thread,
+                64,
+                repeats
+        ));
+#if SERAPH_HAS_BOOST_LOCKFREE_QUEUE
+        append_samples(bench_mt_batched_pop<BoostQueue, false>(
+                "BoostQueue",
+                thread_count,
+                specialized_ops_per_thread,
+                64,
+                repeats
+        ));
+#endif
+    }
+
+    print_allocation_tally("contention", contention_allocations);
+    print_allocation_tally("mt_push_only", push_only_allocations);
+    print_allocation_tally("mt_pop_only", pop_only_allocations);
+    print_allocation_tally("mt_handoff", handoff_allocations);
+
     const auto aggregates = build_aggregates(samples);
 
     const auto repo_root = find_repo_root();
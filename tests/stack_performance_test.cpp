@@ -1,15 +1,22 @@
+#include "seraph/sharded_stack.hpp"
 #include "seraph/stack.hpp"
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <barrier>
 #include <chrono>
 #include <cstdint>
+#include <ctime>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <map>
+#include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <optional>
 #include <sstream>
@@ -32,6 +39,12 @@
 #define SERAPH_HAS_BOOST_LOCKFREE_STACK 0
 #endif
 
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+
 namespace {
     using Clock = std::chrono::steady_clock;
 
@@ -150,6 +163,204 @@ namespace {
         std::stack<int, std::vector<int>> data_;
     };
 
+    // Detects contention with the shared active-operation counter instead of lock failures. With
+    // `Eager`, it promotes to CAS mode on the first overlapping operations so node allocation is on
+    // the path; otherwise it keeps the default thresholds.
+    template <typename CasPolicy, bool Eager = true> class BasicActiveOpsStackAdapter {
+      public:
+        BasicActiveOpsStackAdapter()
+            : data_(0,
+                    Eager ? 2 : seraph::promotion_policy{}.thread_threshold,
+                    Eager ? 1 : seraph::promotion_policy{}.promotion_streak,
+                    seraph::contention_detector::active_operations) {}
+
+        void push(const int& value) {
+            data_.push(value);
+        }
+
+        template <typename InputIt> void push_range(InputIt first, InputIt last) {
+            data_.push_range(first, last);
+        }
+
+        template <typename OutputIt> size_t pop_bulk(size_t n, OutputIt out) {
+            return data_.pop_bulk(n, out);
+        }
+
+        template <typename OutputIt> size_t snapshot(OutputIt out) const {
+            return data_.snapshot(out);
+        }
+
+        void push(int&& value) {
+            data_.push(std::move(value));
+        }
+
+        template <typename... Args> void emplace(Args&&... args) {
+            data_.emplace(std::forward<Args>(args)...);
+        }
+
+        std::optional<int> pop() {
+            return data_.pop();
+        }
+
+        bool empty() const noexcept {
+            return data_.empty();
+        }
+
+        size_t size() const noexcept {
+            return data_.size();
+        }
+
+        bool is_using_cas() const noexcept {
+            return data_.is_using_cas();
+        }
+
+      private:
+        seraph::stack<int, CasPolicy> data_;
+    };
+
+    using EagerCasStackAdapter = BasicActiveOpsStackAdapter<seraph::hazard_pointer_cas>;
+    using TaggedCasStackAdapter = BasicActiveOpsStackAdapter<seraph::tagged_pointer_cas>;
+    using UnrolledCasStackAdapter = BasicActiveOpsStackAdapter<seraph::unrolled_cas>;
+    using ActiveOpsStackAdapter = BasicActiveOpsStackAdapter<seraph::hazard_pointer_cas, false>;
+
+    // Promoted stack plus one size counter shared by all threads, bumped on every operation the way
+    // the CAS path counted before its size stripes. Read against "stack_cas" for what the shared
+    // counter line costs.
+    class SharedCountCasStackAdapter {
+      public:
+        void push(const int& value) {
+            data_.push(value);
+            size_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void push(int&& value) {
+            data_.push(std::move(value));
+            size_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        template <typename... Args> void emplace(Args&&... args) {
+            data_.emplace(std::forward<Args>(args)...);
+            size_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::optional<int> pop() {
+            std::optional<int> value(data_.pop());
+            if (value.has_value()) {
+                size_.fetch_sub(1, std::memory_order_relaxed);
+            }
+            return value;
+        }
+
+        bool empty() const noexcept {
+            return data_.empty();
+        }
+
+        size_t size() const noexcept {
+            return size_.load(std::memory_order_relaxed);
+        }
+
+      private:
+        EagerCasStackAdapter data_;
+        alignas(64) std::atomic<size_t> size_{0};
+    };
+
+    // Vector mode only: promotion is disabled so the rows compare the spin-mode lock policies.
+    template <typename Lock> class BasicSpinOnlyStackAdapter {
+      public:
+        BasicSpinOnlyStackAdapter() : data_(0, 2, std::numeric_limits<size_t>::max()) {}
+
+        void push(const int& value) {
+            data_.push(value);
+        }
+
+        void push(int&& value) {
+            data_.push(std::move(value));
+        }
+
+        template <typename... Args> void emplace(Args&&... args) {
+            data_.emplace(std::forward<Args>(args)...);
+        }
+
+        std::optional<int> pop() {
+            return data_.pop();
+        }
+
+        bool empty() const noexcept {
+            return data_.empty();
+        }
+
+        size_t size() const noexcept {
+            return data_.size();
+        }
+
+      private:
+        seraph::stack<int, seraph::hazard_pointer_cas, std::allocator<int>, Lock> data_;
+    };
+
+    using SpinOnlyTtasStackAdapter = BasicSpinOnlyStackAdapter<Spinlock>;
+    using SpinOnlyMcsStackAdapter = BasicSpinOnlyStackAdapter<McsLock>;
+
+    // Request-scoped stack: vector and node storage come from a monotonic arena that is released
+    // in one go with the stack. With `Eager`, it promotes like EagerCasStackAdapter and takes
+    // its storage from a synchronized pool instead, since nodes are then allocated from several
+    // threads and a monotonic arena is not thread-safe.
+    template <bool Eager> class BasicArenaStackAdapter {
+      public:
+        using Stack = seraph::
+                stack<int, seraph::hazard_pointer_cas, std::pmr::polymorphic_allocator<int>>;
+
+        BasicArenaStackAdapter() : data_(make_stack()) {}
+
+        void push(const int& value) {
+            data_->push(value);
+        }
+
+        void push(int&& value) {
+            data_->push(std::move(value));
+        }
+
+        template <typename... Args> void emplace(Args&&... args) {
+            data_->emplace(std::forward<Args>(args)...);
+        }
+
+        std::optional<int> pop() {
+            return data_->pop();
+        }
+
+        bool empty() const noexcept {
+            return data_->empty();
+        }
+
+        size_t size() const noexcept {
+            return data_->size();
+        }
+
+      private:
+        std::unique_ptr<Stack> make_stack() {
+            if constexpr (Eager) {
+                return std::make_unique<Stack>(
+                        0,
+                        2,
+                        1,
+                        seraph::contention_detector::active_operations,
+                        std::make_shared<Stack::hazard_domain>(
+                                std::pmr::polymorphic_allocator<int>(&pool_)
+                        )
+                );
+            }
+            else {
+                return std::make_unique<Stack>(std::pmr::polymorphic_allocator<int>(&arena_));
+            }
+        }
+
+        std::pmr::synchronized_pool_resource pool_;
+        std::pmr::monotonic_buffer_resource arena_;
+        std::unique_ptr<Stack> data_;
+    };
+
+    using ArenaStackAdapter = BasicArenaStackAdapter<false>;
+    using PoolCasStackAdapter = BasicArenaStackAdapter<true>;
+
 #if SERAPH_HAS_BOOST_LOCKFREE_STACK
     class BoostLockfreeStackAdapter {
       public:
@@ -442,6 +653,86 @@ namespace {
         );
     }
 
+    // Half pushes, half pops on a stack holding `depth` values. With `with_snapshot`, another
+    // thread copies the whole stack out every millisecond, the way a metrics exporter would.
+    template <typename StackType>
+    std::vector<BenchmarkSample> bench_mix_under_snapshot(
+            std::string_view impl_name,
+            int thread_count,
+            size_t depth,
+            size_t ops_per_thread,
+            bool with_snapshot,
+            int repeats
+    ) {
+        const size_t total_ops = static_cast<size_t>(thread_count) * ops_per_thread;
+        const std::string op_label = std::string(with_snapshot ? "mix_snapshot_t" : "mix_t") +
+                                     std::to_string(thread_count);
+        return run_samples(
+                impl_name,
+                op_label,
+                total_ops,
+                repeats,
+                [thread_count, depth, ops_per_thread, with_snapshot]() {
+                    StackType stack;
+                    for (size_t iii = 0; iii < depth; ++iii) {
+                        stack.emplace(static_cast<int>(iii));
+                    }
+
+                    std::barrier sync_start(thread_count + 1);
+                    std::atomic<bool> done{false};
+                    std::atomic<std::uint64_t> pop_sum{0};
+                    std::vector<std::thread> workers;
+                    workers.reserve(static_cast<size_t>(thread_count));
+
+                    for (int thread_index = 0; thread_index < thread_count; ++thread_index) {
+                        workers.emplace_back([&, thread_index]() {
+                            std::uint64_t local_sum = 0;
+                            sync_start.arrive_and_wait();
+                            for (size_t iii = 0; iii < ops_per_thread; ++iii) {
+                                if (((iii + static_cast<size_t>(thread_index)) & 1U) == 0) {
+                                    stack.push(static_cast<int>(iii));
+                                }
+                                else {
+                                    auto value = stack.pop();
+                                    if (value.has_value()) {
+                                        local_sum += static_cast<std::uint64_t>(*value);
+                                    }
+                                }
+                            }
+                            pop_sum.fetch_add(local_sum, std::memory_order_relaxed);
+                        });
+                    }
+
+                    std::thread exporter;
+                    if (with_snapshot) {
+                        exporter = std::thread([&]() {
+                            std::vector<int> copy;
+                            copy.reserve(depth * 2);
+                            while (!done.load(std::memory_order_relaxed)) {
+                                copy.clear();
+                                pop_sum.fetch_add(
+                                        stack.snapshot(std::back_inserter(copy)),
+                                        std::memory_order_relaxed
+                                );
+                                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                            }
+                        });
+                    }
+
+                    sync_start.arrive_and_wait();
+                    for (auto& worker : workers) {
+                        worker.join();
+                    }
+
+                    done.store(true, std::memory_order_relaxed);
+                    if (exporter.joinable()) {
+                        exporter.join();
+                    }
+                    g_sink += pop_sum.load(std::memory_order_relaxed);
+                }
+        );
+    }
+
     std::string make_mt_simple_operation_label(std::string_view mode, int thread_count) {
         return "mt_" + std::string(mode) + "_t" + std::to_string(thread_count);
     }
@@ -485,50 +776,536 @@ namespace {
         );
     }
 
-    template <typename StackType>
-    std::vector<BenchmarkSample> bench_mt_pop_only(
+    template <typename StackType>
+    std::vector<BenchmarkSample> bench_mt_pop_only(
+            std::string_view impl_name,
+            int thread_count,
+            size_t ops_per_thread,
+            int repeats
+    ) {
+        const size_t total_ops = static_cast<size_t>(thread_count) * ops_per_thread;
+        const std::string op_label = make_mt_simple_operation_label("pop_only", thread_count);
+        return run_samples(
+                impl_name,
+                op_label,
+                total_ops,
+                repeats,
+                [thread_count, ops_per_thread, total_ops]() {
+                    StackType stack;
+                    for (size_t iii = 0; iii < total_ops; ++iii) {
+                        stack.emplace(static_cast<int>(iii));
+                    }
+
+                    std::barrier sync_start(thread_count + 1);
+                    std::atomic<std::uint64_t> pop_sum{0};
+                    std::vector<std::thread> workers;
+                    workers.reserve(static_cast<size_t>(thread_count));
+
+                    for (int thread_index = 0; thread_index < thread_count; ++thread_index) {
+                        workers.emplace_back([&, thread_index]() {
+                            std::uint64_t local_sum = 0;
+                            sync_start.arrive_and_wait();
+                            for (size_t iii = 0; iii < ops_per_thread; ++iii) {
+                                auto value = stack.pop();
+                                if (value.has_value()) {
+                                    local_sum += static_cast<std::uint64_t>(*value);
+                                }
+                            }
+                            pop_sum.fetch_add(local_sum, std::memory_order_relaxed);
+                        });
+                    }
+
+                    sync_start.arrive_and_wait();
+                    for (auto& worker : workers) {
+                        worker.join();
+                    }
+                    g_sink += pop_sum.load(std::memory_order_relaxed);
+                }
+        );
+    }
+
+    // Allocation-heavy steady state: each thread pushes a burst and pops it back, so every push
+    // needs a node and every pop retires one.
+    template <typename StackType>
+    std::vector<BenchmarkSample> bench_mt_alloc_churn(
+            std::string_view impl_name,
+            int thread_count,
+            size_t ops_per_thread,
+            int repeats
+    ) {
+        constexpr size_t k_burst = 32;
+        const size_t total_ops = static_cast<size_t>(thread_count) * ops_per_thread;
+        const std::string op_label = make_mt_simple_operation_label("alloc_churn", thread_count);
+        return run_samples(
+                impl_name,
+                op_label,
+                total_ops,
+                repeats,
+                [thread_count, ops_per_thread]() {
+                    StackType stack;
+                    std::barrier sync_start(thread_count + 1);
+                    std::atomic<std::uint64_t> pop_sum{0};
+                    std::vector<std::thread> workers;
+                    workers.reserve(static_cast<size_t>(thread_count));
+
+                    for (int thread_index = 0; thread_index < thread_count; ++thread_index) {
+                        workers.emplace_back([&, thread_index]() {
+                            std::uint64_t local_sum = 0;
+                            sync_start.arrive_and_wait();
+                            for (size_t iii = 0; iii < ops_per_thread; iii += 2 * k_burst) {
+                                for (size_t jjj = 0; jjj < k_burst; ++jjj) {
+                                    stack.push(static_cast<int>(jjj) + thread_index);
+                                }
+                                for (size_t jjj = 0; jjj < k_burst; ++jjj) {
+                                    auto value = stack.pop();
+                                    if (value.has_value()) {
+                                        local_sum += static_cast<std::uint64_t>(*value);
+                                    }
+                                }
+                            }
+                            pop_sum.fetch_add(local_sum, std::memory_order_relaxed);
+                        });
+                    }
+
+                    sync_start.arrive_and_wait();
+                    for (auto& worker : workers) {
+                        worker.join();
+                    }
+                    g_sink += pop_sum.load(std::memory_order_relaxed);
+                }
+        );
+    }
+
+    // Producers that work in batches: each round pushes `batch_size` values and pops as many back,
+    // either through push_range/pop_bulk ("batch") or one call per value ("items").
+    template <typename StackType, bool UseBatchApi>
+    std::vector<BenchmarkSample> bench_mt_batched(
+            std::string_view impl_name,
+            int thread_count,
+            size_t ops_per_thread,
+            size_t batch_size,
+            int repeats
+    ) {
+        const size_t rounds = std::max<size_t>(1, ops_per_thread / (2 * batch_size));
+        const size_t total_ops = static_cast<size_t>(thread_count) * rounds * 2 * batch_size;
+        const std::string op_label = make_mt_simple_operation_label(
+                (UseBatchApi ? "batch" : "items") + std::to_string(batch_size),
+                thread_count
+        );
+        return run_samples(
+                impl_name,
+                op_label,
+                total_ops,
+                repeats,
+                [thread_count, rounds, batch_size]() {
+                    StackType stack;
+                    std::barrier sync_start(thread_count + 1);
+                    std::atomic<std::uint64_t> pop_sum{0};
+                    std::vector<std::thread> workers;
+                    workers.reserve(static_cast<size_t>(thread_count));
+
+                    for (int thread_index = 0; thread_index < thread_count; ++thread_index) {
+                        workers.emplace_back([&, thread_index]() {
+                            std::vector<int> values(batch_size);
+                            std::vector<int> popped(batch_size);
+                            std::uint64_t local_sum = 0;
+
+                            for (size_t iii = 0; iii < batch_size; ++iii) {
+                                values[iii] = static_cast<int>(iii) + thread_index;
+                            }
+
+                            sync_start.arrive_and_wait();
+                            for (size_t round = 0; round < rounds; ++round) {
+                                if constexpr (UseBatchApi) {
+                                    stack.push_range(values.begin(), values.end());
+                                    const size_t count = stack.pop_bulk(batch_size, popped.begin());
+                                    for (size_t iii = 0; iii < count; ++iii) {
+                                        local_sum += static_cast<std::uint64_t>(popped[iii]);
+                                    }
+                                }
+                                else {
+                                    for (const int value : values) {
+                                        stack.push(value);
+                                    }
+                                    for (size_t iii = 0; iii < batch_size; ++iii) {
+                                        auto value = stack.pop();
+                                        if (value.has_value()) {
+                                            local_sum += static_cast<std::uint64_t>(*value);
+                                        }
+                                    }
+                                }
+                            }
+                            pop_sum.fetch_add(local_sum, std::memory_order_relaxed);
+                        });
+                    }
+
+                    sync_start.arrive_and_wait();
+                    for (auto& worker : workers) {
+                        worker.join();
+                    }
+                    g_sink += pop_sum.load(std::memory_order_relaxed);
+                }
+        );
+    }
+
+    // Burst, then quiet, then burst on one stack. Each phase is recorded as its own operation so the
+    // quiet phase can be compared with single-threaded vector-mode throughput.
+    template <typename StackType>
+    std::vector<BenchmarkSample> bench_phased(
+            std::string_view impl_name,
+            int thread_count,
+            size_t ops_per_thread,
+            size_t quiet_ops,
+            int repeats
+    ) {
+        std::vector<BenchmarkSample> samples;
+        const std::string suffix = "_t" + std::to_string(thread_count);
+        const size_t burst_ops = static_cast<size_t>(thread_count) * ops_per_thread;
+
+        auto record = [&](std::string operation, size_t iterations, int repeat, double measured_ns) {
+            const double total_ns = std::max(1.0, measured_ns);
+            const double ns_per_op = total_ns / static_cast<double>(iterations);
+            samples.push_back(BenchmarkSample{
+                    .implementation = std::string(impl_name),
+                    .operation = std::move(operation),
+                    .iterations = iterations,
+                    .repeat_index = repeat,
+                    .total_ns = total_ns,
+                    .nanoseconds_per_op = ns_per_op,
+                    .ops_per_second = 1e9 / ns_per_op,
+            });
+        };
+
+        for (int repeat = 0; repeat < repeats; ++repeat) {
+            StackType stack;
+
+            auto run_burst = [&]() {
+                std::barrier sync_start(thread_count + 1);
+                std::atomic<std::uint64_t> pop_sum{0};
+                std::vector<std::thread> workers;
+                workers.reserve(static_cast<size_t>(thread_count));
+
+                for (int thread_index = 0; thread_index < thread_count; ++thread_index) {
+                    workers.emplace_back([&, thread_index]() {
+                        std::uint64_t local_sum = 0;
+                        sync_start.arrive_and_wait();
+                        for (size_t iii = 0; iii < ops_per_thread; ++iii) {
+                            if ((iii & 1U) == 0) {
+                                stack.push(static_cast<int>(iii) + thread_index);
+                            }
+                            else {
+                                auto value = stack.pop();
+                                if (value.has_value()) {
+                                    local_sum += static_cast<std::uint64_t>(*value);
+                                }
+                            }
+                        }
+                        pop_sum.fetch_add(local_sum, std::memory_order_relaxed);
+                    });
+                }
+
+                const auto start = Clock::now();
+                sync_start.arrive_and_wait();
+                for (auto& worker : workers) {
+                    worker.join();
+                }
+                const auto stop = Clock::now();
+                g_sink += pop_sum.load(std::memory_order_relaxed);
+                return std::chrono::duration<double, std::nano>(stop - start).count();
+            };
+
+            auto run_quiet = [&]() {
+                std::uint64_t local_sum = 0;
+                const auto start = Clock::now();
+                for (size_t iii = 0; iii < quiet_ops; ++iii) {
+                    if ((iii & 1U) == 0) {
+                        stack.push(static_cast<int>(iii));
+                    }
+                    else {
+                        auto value = stack.pop();
+                        if (value.has_value()) {
+                            local_sum += static_cast<std::uint64_t>(*value);
+                        }
+                    }
+                }
+                const auto stop = Clock::now();
+                g_sink += local_sum;
+                return std::chrono::duration<double, std::nano>(stop - start).count();
+            };
+
+            record("phased_1_burst" + suffix, burst_ops, repeat, run_burst());
+            record("phased_2_quiet" + suffix, quiet_ops, repeat, run_quiet());
+            record("phased_3_burst" + suffix, burst_ops, repeat, run_burst());
+        }
+
+        return samples;
+    }
+
+    // Fills a vector-mode stack with `elements` values, then lets two threads push until one of
+    // them promotes it. The slowest single operation either thread saw is the promotion stall.
+    std::vector<BenchmarkSample> bench_promotion_stall(
+            std::string_view impl_name,
+            size_t elements,
+            int repeats
+    ) {
+        std::vector<BenchmarkSample> samples;
+        const std::string operation = "promotion_stall_" + std::to_string(elements);
+
+        for (int repeat = 0; repeat < repeats; ++repeat) {
+            EagerCasStackAdapter stack;
+            for (size_t iii = 0; iii < elements; ++iii) {
+                stack.push(static_cast<int>(iii));
+            }
+
+            constexpr int k_threads = 2;
+            std::barrier sync_start(k_threads);
+            std::array<double, k_threads> max_op_ns{};
+            std::vector<std::thread> workers;
+
+            for (int thread_index = 0; thread_index < k_threads; ++thread_index) {
+                workers.emplace_back([&, thread_index]() {
+                    sync_start.arrive_and_wait();
+                    while (!stack.is_using_cas()) {
+                        const auto start = Clock::now();
+                        stack.push(thread_index);
+                        const auto stop = Clock::now();
+                        max_op_ns[static_cast<size_t>(thread_index)] = std::max(
+                                max_op_ns[static_cast<size_t>(thread_index)],
+                                std::chrono::duration<double, std::nano>(stop - start).count()
+                        );
+                    }
+                });
+            }
+
+            for (auto& worker : workers) {
+                worker.join();
+            }
+
+            const double stall_ns =
+                    std::max(1.0, *std::max_element(max_op_ns.begin(), max_op_ns.end()));
+            g_sink += stack.size();
+            samples.push_back(BenchmarkSample{
+                    .implementation = std::string(impl_name),
+                    .operation = operation,
+                    .iterations = 1,
+                    .repeat_index = repeat,
+                    .total_ns = stall_ns,
+                    .nanoseconds_per_op = stall_ns,
+                    .ops_per_second = 1e9 / stall_ns,
+            });
+        }
+
+        return samples;
+    }
+
+    size_t current_rss_bytes() {
+#if defined(__APPLE__)
+        mach_task_basic_info_data_t info{};
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(
+                    mach_task_self(),
+                    MACH_TASK_BASIC_INFO,
+                    reinterpret_cast<task_info_t>(&info),
+                    &count
+            ) != KERN_SUCCESS) {
+            return 0;
+        }
+        return static_cast<size_t>(info.resident_size);
+#else
+        std::ifstream statm("/proc/self/statm");
+        size_t total_pages = 0;
+        size_t resident_pages = 0;
+        statm >> total_pages >> resident_pages;
+        return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    }
+
+    // Thread-per-burst service: every round starts fresh worker threads that churn one long-lived
+    // CAS-mode stack and exit. Resident memory should level off after the first rounds instead of
+    // growing with the number of threads that came and went.
+    void report_thread_burst_rss(int thread_count, size_t ops_per_thread, int rounds) {
+        constexpr size_t k_burst = 32;
+        seraph::stack<int> stack(0, 2, 1, seraph::contention_detector::active_operations);
+
+        std::cout << "Thread bursts (t" << thread_count << "): RSS KiB per round:";
+        for (int round = 0; round < rounds; ++round) {
+            std::atomic<std::uint64_t> pop_sum{0};
+            std::vector<std::thread> workers;
+            workers.reserve(static_cast<size_t>(thread_count));
+
+            for (int thread_index = 0; thread_index < thread_count; ++thread_index) {
+                workers.emplace_back([&stack, &pop_sum, ops_per_thread, thread_index]() {
+                    std::uint64_t local_sum = 0;
+                    for (size_t iii = 0; iii < ops_per_thread; iii += 2 * k_burst) {
+                        for (size_t jjj = 0; jjj < k_burst; ++jjj) {
+                            stack.push(static_cast<int>(jjj) + thread_index);
+                        }
+                        for (size_t jjj = 0; jjj < k_burst; ++jjj) {
+                            auto value = stack.pop();
+                            if (value.has_value()) {
+                                local_sum += static_cast<std::uint64_t>(*value);
+                            }
+                        }
+                    }
+                    pop_sum.fetch_add(local_sum, std::memory_order_relaxed);
+                });
+            }
+
+            for (auto& worker : workers) {
+                worker.join();
+            }
+
+            g_sink += pop_sum.load(std::memory_order_relaxed);
+            std::cout << " " << current_rss_bytes() / 1024;
+        }
+
+        const size_t pending = stack.reclaim();
+        std::cout << "; after reclaim(): " << current_rss_bytes() / 1024 << " KiB, " << pending
+                  << " nodes still protected, " << stack.domain()->record_count()
+                  << " hazard records\n";
+    }
+
+    // Latency of each push while one thread grows a stack from empty to `count` values. Behind
+    // one contiguous vector, the pushes that reallocate copy every value and make up the tail.
+    template <typename StackType>
+    void report_growth_latency(std::string_view impl_name, size_t count) {
+        std::vector<std::uint32_t> latencies(count);
+        StackType stack;
+
+        for (size_t iii = 0; iii < count; ++iii) {
+            const auto start = Clock::now();
+            stack.push(static_cast<int>(iii));
+            const auto stop = Clock::now();
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start);
+            latencies[iii] = static_cast<std::uint32_t>(std::min<std::int64_t>(
+                    ns.count(), std::numeric_limits<std::uint32_t>::max()
+            ));
+        }
+
+        g_sink += stack.size();
+        std::sort(latencies.begin(), latencies.end());
+
+        auto percentile = [&latencies](double fraction) {
+            const double rank = fraction * static_cast<double>(latencies.size());
+            return latencies[std::min(static_cast<size_t>(rank), latencies.size() - 1)];
+        };
+
+        std::cout << "Growth to " << count << " (" << impl_name << "): push ns p50 "
+                  << percentile(0.5) << ", p99 " << percentile(0.99) << ", p99.9 "
+                  << percentile(0.999) << ", p99.99 " << percentile(0.9999) << ", max "
+                  << latencies.back() << "\n";
+    }
+
+    double thread_cpu_ms() {
+        timespec now{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        return static_cast<double>(now.tv_sec) * 1e3 + static_cast<double>(now.tv_nsec) / 1e6;
+    }
+
+    // One consumer waits on an empty stack while the producer idles for `idle`, then pushes a
+    // single value. Blocking reports pop_wait(), otherwise the consumer spins on pop(). Returns
+    // the consumer's wake-up latency per round and adds its CPU time while idle to `idle_cpu_ms`.
+    std::vector<BenchmarkSample> bench_wake_latency(
+            std::string_view impl_name,
+            bool blocking,
+            std::chrono::microseconds idle,
+            int rounds,
+            double& idle_cpu_ms
+    ) {
+        std::vector<BenchmarkSample> samples;
+        seraph::stack<int> stack;
+
+        for (int round = 0; round < rounds; ++round) {
+            std::atomic<Clock::rep> pushed_at{0};
+            double latency_ns = 0.0;
+            double cpu_ms = 0.0;
+
+            std::thread consumer([&]() {
+                const double cpu_start = thread_cpu_ms();
+                int value = 0;
+                if (blocking) {
+                    value = stack.pop_wait();
+                }
+                else {
+                    std::optional<int> popped;
+                    while (!(popped = stack.pop())) {
+                    }
+                    value = *popped;
+                }
+                const auto woke_at = Clock::now();
+                cpu_ms = thread_cpu_ms() - cpu_start;
+                const Clock::time_point pushed(Clock::duration(pushed_at.load()));
+                latency_ns = std::chrono::duration<double, std::nano>(woke_at - pushed).count();
+                g_sink += static_cast<std::uint64_t>(value);
+            });
+
+            std::this_thread::sleep_for(idle);
+            pushed_at.store(Clock::now().time_since_epoch().count());
+            stack.push(round);
+            consumer.join();
+
+            idle_cpu_ms += cpu_ms;
+            latency_ns = std::max(1.0, latency_ns);
+            samples.push_back(BenchmarkSample{
+                    .implementation = std::string(impl_name),
+                    .operation = "wake_latency",
+                    .iterations = 1,
+                    .repeat_index = round,
+                    .total_ns = latency_ns,
+                    .nanoseconds_per_op = latency_ns,
+                    .ops_per_second = 1e9 / latency_ns,
+            });
+        }
+
+        return samples;
+    }
+
+    // 256-byte payload, where the extra move through std::optional in pop() shows up.
+    struct Message {
+        std::array<std::uint64_t, 32> words{};
+    };
+
+    // consume mode: 0 = pop(), 1 = try_pop(T&), 2 = consume_all().
+    std::vector<BenchmarkSample> bench_message_consume(
             std::string_view impl_name,
-            int thread_count,
-            size_t ops_per_thread,
+            int mode,
+            size_t iterations,
             int repeats
     ) {
-        const size_t total_ops = static_cast<size_t>(thread_count) * ops_per_thread;
-        const std::string op_label = make_mt_simple_operation_label("pop_only", thread_count);
+        static constexpr std::array<std::string_view, 3> k_operations{
+                "message_pop", "message_try_pop", "message_consume_all"
+        };
+
         return run_samples(
                 impl_name,
-                op_label,
-                total_ops,
+                k_operations[static_cast<size_t>(mode)],
+                iterations,
                 repeats,
-                [thread_count, ops_per_thread, total_ops]() {
-                    StackType stack;
-                    for (size_t iii = 0; iii < total_ops; ++iii) {
-                        stack.emplace(static_cast<int>(iii));
+                [mode, iterations]() {
+                    seraph::stack<Message> stack(iterations);
+                    Message message;
+                    for (size_t iii = 0; iii < iterations; ++iii) {
+                        message.words[0] = iii;
+                        stack.push(message);
                     }
 
-                    std::barrier sync_start(thread_count + 1);
-                    std::atomic<std::uint64_t> pop_sum{0};
-                    std::vector<std::thread> workers;
-                    workers.reserve(static_cast<size_t>(thread_count));
-
-                    for (int thread_index = 0; thread_index < thread_count; ++thread_index) {
-                        workers.emplace_back([&, thread_index]() {
-                            std::uint64_t local_sum = 0;
-                            sync_start.arrive_and_wait();
-                            for (size_t iii = 0; iii < ops_per_thread; ++iii) {
-                                auto value = stack.pop();
-                                if (value.has_value()) {
-                                    local_sum += static_cast<std::uint64_t>(*value);
-                                }
-                            }
-                            pop_sum.fetch_add(local_sum, std::memory_order_relaxed);
-                        });
+                    std::uint64_t local_sum = 0;
+                    if (mode == 0) {
+                        while (auto value = stack.pop()) {
+                            local_sum += value->words[0];
+                        }
                     }
-
-                    sync_start.arrive_and_wait();
-                    for (auto& worker : workers) {
-                        worker.join();
+                    else if (mode == 1) {
+                        while (stack.try_pop(message)) {
+                            local_sum += message.words[0];
+                        }
                     }
-                    g_sink += pop_sum.load(std::memory_order_relaxed);
+                    else {
+                        stack.consume_all([&local_sum](Message&& value) {
+                            local_sum += value.words[0];
+                        });
+                    }
+                    g_sink += local_sum;
                 }
         );
     }
@@ -606,6 +1383,21 @@ namespace {
         if (impl == "BoostStack") {
             return "#e76f51";
         }
+        if (impl == "stack_cas") {
+            return "#e9c46a";
+        }
+        if (impl == "stack_active_ops") {
+            return "#8ab17d";
+        }
+        if (impl == "sharded_stack") {
+            return "#9b5de5";
+        }
+        if (impl == "stack_tagged") {
+            return "#f4a261";
+        }
+        if (impl == "stack_unrolled") {
+            return "#457b9d";
+        }
         return "#264653";
     }
 
@@ -628,7 +1420,14 @@ namespace {
             }
         }
 
-        std::vector<std::string> impls = {"stack"};
+        std::vector<std::string> impls = {
+                "stack",
+                "stack_cas",
+                "stack_tagged",
+                "stack_unrolled",
+                "stack_active_ops",
+                "sharded_stack",
+        };
 #if SERAPH_HAS_BOOST_LOCKFREE_STACK
         impls.push_back("BoostStack");
 #endif
@@ -1075,11 +1874,172 @@ namespace {
         out << "</svg>\n";
     }
 
+    // One contention-mix workload on a seraph::stack<int> running `policy`, averaged over
+    // `repeats`. `stats` receives the counters of the last repeat.
+    double measure_policy_mix(
+            const seraph::promotion_policy& policy,
+            int thread_count,
+            int push_percent,
+            size_t ops_per_thread,
+            int repeats,
+            seraph::contention_stats& stats
+    ) {
+        double total_ops_per_sec = 0.0;
+
+        for (int repeat = 0; repeat < repeats; ++repeat) {
+            seraph::stack<int> stack;
+            stack.set_promotion_policy(policy);
+            const size_t total_ops = static_cast<size_t>(thread_count) * ops_per_thread;
+            for (size_t iii = 0; iii < total_ops; ++iii) {
+                stack.emplace(static_cast<int>(iii));
+            }
+
+            std::barrier sync_start(thread_count + 1);
+            std::atomic<std::uint64_t> pop_sum{0};
+            std::vector<std::thread> workers;
+            workers.reserve(static_cast<size_t>(thread_count));
+
+            for (int thread_index = 0; thread_index < thread_count; ++thread_index) {
+                workers.emplace_back([&, thread_index]() {
+                    std::uint64_t seed =
+                            0x9e3779b97f4a7c15ULL ^ static_cast<std::uint64_t>(thread_index + 1);
+                    std::uint64_t local_sum = 0;
+
+                    sync_start.arrive_and_wait();
+                    for (size_t iii = 0; iii < ops_per_thread; ++iii) {
+                        seed ^= seed << 13;
+                        seed ^= seed >> 7;
+                        seed ^= seed << 17;
+
+                        if (static_cast<int>(seed % 100ULL) < push_percent) {
+                            stack.push(static_cast<int>(iii));
+                        }
+                        else if (auto value = stack.pop(); value.has_value()) {
+                            local_sum += static_cast<std::uint64_t>(*value);
+                        }
+                    }
+                    pop_sum.fetch_add(local_sum, std::memory_order_relaxed);
+                });
+            }
+
+            const auto start = Clock::now();
+            sync_start.arrive_and_wait();
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            const auto stop = Clock::now();
+
+            const double seconds =
+                    std::max(1e-9, std::chrono::duration<double>(stop - start).count());
+            total_ops_per_sec += static_cast<double>(total_ops) / seconds;
+            stats = stack.get_contention_stats();
+            g_sink += pop_sum.load(std::memory_order_relaxed);
+        }
+
+        return total_ops_per_sec / static_cast<double>(repeats);
+    }
+
+    std::string describe_policy(const seraph::promotion_policy& policy) {
+        std::ostringstream out;
+        if (policy.detector == seraph::contention_detector::lock_failures) {
+            out << "lock_failures";
+        }
+        else {
+            out << "active_operations threads=" << policy.thread_threshold;
+        }
+        out << " promote=" << policy.promotion_streak << " demote=" << policy.demotion_streak;
+        return out.str();
+    }
+
+    // --tune: sweeps promotion policies over each workload mix on this host and prints the
+    // fastest one next to the default, with the failure rates it ran at.
+    void run_tune_mode(bool quick) {
+        const size_t ops_per_thread = quick ? 10'000 : 100'000;
+        const int repeats = quick ? 1 : 3;
+        const std::vector<int> thread_counts = {2, 4, 8};
+        const std::vector<int> push_percents = {20, 50, 80};
+        const std::vector<size_t> promotion_streaks = {4, 16, 64, 256, 1024};
+        const std::vector<size_t> demotion_streaks = {1024, 4096, 16384};
+
+        std::vector<seraph::promotion_policy> candidates;
+        for (const size_t promote : promotion_streaks) {
+            for (const size_t demote : demotion_streaks) {
+                candidates.push_back(seraph::promotion_policy{
+                        .detector = seraph::contention_detector::lock_failures,
+                        .promotion_streak = promote,
+                        .demotion_streak = demote,
+                });
+
+                for (const size_t threads : {size_t{2}, size_t{3}, size_t{4}}) {
+                    candidates.push_back(seraph::promotion_policy{
+                            .detector = seraph::contention_detector::active_operations,
+                            .thread_threshold = threads,
+                            .promotion_streak = promote,
+                            .demotion_streak = demote,
+                    });
+                }
+            }
+        }
+
+        std::cout << "Tuning " << candidates.size() << " promotion policies, " << ops_per_thread
+                  << " ops/thread, " << repeats << " repeat(s) each\n";
+
+        for (const int thread_count : thread_counts) {
+            for (const int push_percent : push_percents) {
+                seraph::contention_stats stats;
+                const double default_ops = measure_policy_mix(
+                        seraph::promotion_policy{},
+                        thread_count,
+                        push_percent,
+                        ops_per_thread,
+                        repeats,
+                        stats
+                );
+
+                seraph::promotion_policy best_policy;
+                seraph::contention_stats best_stats = stats;
+                double best_ops = default_ops;
+
+                for (const seraph::promotion_policy& policy : candidates) {
+                    const double ops = measure_policy_mix(
+                            policy,
+                            thread_count,
+                            push_percent,
+                            ops_per_thread,
+                            repeats,
+                            stats
+                    );
+
+                    if (ops > best_ops) {
+                        best_ops = ops;
+                        best_policy = policy;
+                        best_stats = stats;
+                    }
+                }
+
+                const double total_ops =
+                        static_cast<double>(static_cast<size_t>(thread_count) * ops_per_thread);
+                std::cout << make_contention_operation_label(thread_count, push_percent) << ": "
+                          << describe_policy(best_policy) << " | " << std::fixed
+                          << std::setprecision(0) << best_ops << " ops/s vs default "
+                          << default_ops << " (" << std::setprecision(1)
+                          << 100.0 * (best_ops / default_ops - 1.0) << "%) | lock failures/op "
+                          << std::setprecision(4)
+                          << static_cast<double>(best_stats.lock_failures) / total_ops
+                          << ", CAS failures/op "
+                          << static_cast<double>(best_stats.cas_failures) / total_ops
+                          << ", promotions " << best_stats.promotions << ", demotions "
+                          << best_stats.demotions << "\n";
+            }
+        }
+    }
+
 } // namespace
 
 int main(int argc, char** argv) {
     bool quick = false;
     bool allow_debug = false;
+    bool tune = false;
 
     for (int iii = 1; iii < argc; ++iii) {
         const std::string arg(argv[iii]);
@@ -1089,6 +2049,9 @@ int main(int argc, char** argv) {
         else if (arg == "--allow-debug") {
             allow_debug = true;
         }
+        else if (arg == "--tune") {
+            tune = true;
+        }
     }
 
 #ifndef NDEBUG
@@ -1100,6 +2063,15 @@ int main(int argc, char** argv) {
     }
 #endif
 
+    if (tune) {
+        run_tune_mode(quick);
+        return 0;
+    }
+
+    if constexpr (!seraph::tagged_pointer_cas_supported<int>) {
+        std::cout << "[SKIP] stack_tagged: no lock-free double-width CAS on this target\n";
+    }
+
     const size_t iterations = quick ? 20'000 : 300'000;
     const int repeats = quick ? 2 : 5;
     const size_t contention_ops_per_thread = quick ? 10'000 : 100'000;
@@ -1117,20 +2089,28 @@ int main(int argc, char** argv) {
     };
 
     using SeraphStack = seraph::stack<int>;
+    using ShardedStack = seraph::sharded_stack<int>;
+    using McsStack = seraph::stack<int, seraph::hazard_pointer_cas, std::allocator<int>, McsLock>;
 #if SERAPH_HAS_BOOST_LOCKFREE_STACK
     using BoostStack = BoostLockfreeStackAdapter;
 
     append_samples(bench_push_copy<SeraphStack>("stack", iterations, repeats));
     append_samples(bench_push_copy<BoostStack>("BoostStack", iterations, repeats));
+    append_samples(bench_push_copy<ActiveOpsStackAdapter>("stack_active_ops", iterations, repeats));
+    append_samples(bench_push_copy<ArenaStackAdapter>("stack_arena", iterations, repeats));
 
     append_samples(bench_push_move<SeraphStack>("stack", iterations, repeats));
     append_samples(bench_push_move<BoostStack>("BoostStack", iterations, repeats));
+    append_samples(bench_push_move<ArenaStackAdapter>("stack_arena", iterations, repeats));
 
     append_samples(bench_emplace<SeraphStack>("stack", iterations, repeats));
     append_samples(bench_emplace<BoostStack>("BoostStack", iterations, repeats));
+    append_samples(bench_emplace<ArenaStackAdapter>("stack_arena", iterations, repeats));
 
     append_samples(bench_pop<SeraphStack>("stack", iterations, repeats));
     append_samples(bench_pop<BoostStack>("BoostStack", iterations, repeats));
+    append_samples(bench_pop<ActiveOpsStackAdapter>("stack_active_ops", iterations, repeats));
+    append_samples(bench_pop<ArenaStackAdapter>("stack_arena", iterations, repeats));
 
     append_samples(bench_empty<SeraphStack>("stack", iterations, repeats));
     append_samples(bench_empty<BoostStack>("BoostStack", iterations, repeats));
@@ -1153,6 +2133,64 @@ int main(int argc, char** argv) {
                     contention_ops_per_thread,
                     repeats
             ));
+            append_samples(bench_contention_mix<ActiveOpsStackAdapter>(
+                    "stack_active_ops",
+                    thread_count,
+                    push_percent,
+                    contention_ops_per_thread,
+                    repeats
+            ));
+            append_samples(bench_contention_mix<EagerCasStackAdapter>(
+                    "stack_cas",
+                    thread_count,
+                    push_percent,
+                    contention_ops_per_thread,
+                    repeats
+            ));
+            if constexpr (seraph::tagged_pointer_cas_supported<int>) {
+                append_samples(bench_contention_mix<TaggedCasStackAdapter>(
+                        "stack_tagged",
+                        thread_count,
+                        push_percent,
+                        contention_ops_per_thread,
+                        repeats
+                ));
+            }
+            append_samples(bench_contention_mix<UnrolledCasStackAdapter>(
+                    "stack_unrolled",
+                    thread_count,
+                    push_percent,
+                    contention_ops_per_thread,
+                    repeats
+            ));
+            append_samples(bench_contention_mix<ShardedStack>(
+                    "sharded_stack",
+                    thread_count,
+                    push_percent,
+                    contention_ops_per_thread,
+                    repeats
+            ));
+            append_samples(bench_contention_mix<McsStack>(
+                    "stack_mcs",
+                    thread_count,
+                    push_percent,
+                    contention_ops_per_thread,
+                    repeats
+            ));
+            append_samples(bench_contention_mix<SpinOnlyTtasStackAdapter>(
+                    "stack_spin_ttas",
+                    thread_count,
+                    push_percent,
+                    contention_ops_per_thread,
+                    repeats
+            ));
+            append_samples(bench_contention_mix<SpinOnlyMcsStackAdapter>(
+                    "stack_spin_mcs",
+                    thread_count,
+                    push_percent,
+                    contention_ops_per_thread,
+                    repeats
+            ));
         }
     }
 
@@ -1169,6 +2207,39 @@ int main(int argc, char** argv) {
                 specialized_ops_per_thread,
                 repeats
         ));
+        // Push throughput once promoted: every operation pays only the mode-word check.
+        append_samples(bench_mt_push_only<EagerCasStackAdapter>(
+                "stack_cas",
+                thread_count,
+                specialized_ops_per_thread,
+                repeats
+        ));
+        append_samples(bench_mt_push_only<SharedCountCasStackAdapter>(
+                "stack_cas_shared_count",
+                thread_count,
+                specialized_ops_per_thread,
+                repeats
+        ));
+        if constexpr (seraph::tagged_pointer_cas_supported<int>) {
+            append_samples(bench_mt_push_only<TaggedCasStackAdapter>(
+                    "stack_tagged",
+                    thread_count,
+                    specialized_ops_per_thread,
+                    repeats
+            ));
+        }
+        append_samples(bench_mt_push_only<UnrolledCasStackAdapter>(
+                "stack_unrolled",
+                thread_count,
+                specialized_ops_per_thread,
+                repeats
+        ));
+        append_samples(bench_mt_push_only<ShardedStack>(
+                "sharded_stack",
+                thread_count,
+                specialized_ops_per_thread,
+                repeats
+        ));
 
         append_samples(bench_mt_pop_only<SeraphStack>(
                 "stack",
@@ -1182,6 +2253,187 @@ int main(int argc, char** argv) {
                 specialized_ops_per_thread,
                 repeats
         ));
+        append_samples(bench_mt_pop_only<ShardedStack>(
+                "sharded_stack",
+                thread_count,
+                specialized_ops_per_thread,
+                repeats
+        ));
+        // Pops once promoted: one node per value against one chunk per several values.
+        append_samples(bench_mt_pop_only<EagerCasStackAdapter>(
+                "stack_cas",
+                thread_count,
+                specialized_ops_per_thread,
+                repeats
+        ));
+        append_samples(bench_mt_pop_only<SharedCountCasStackAdapter>(
+                "stack_cas_shared_count",
+                thread_count,
+                specialized_ops_per_thread,
+                repeats
+        ));
+        append_samples(bench_mt_pop_only<UnrolledCasStackAdapter>(
+                "stack_unrolled",
+                thread_count,
+                specialized_ops_per_thread,
+                repeats
+        ));
+    }
+
+    for (const int thread_count : contention_threads) {
+        append_samples(bench_phased<SeraphStack>(
+                "stack",
+                thread_count,
+                specialized_ops_per_thread,
+                iterations,
+                repeats
+        ));
+        append_samples(bench_phased<BoostStack>(
+                "BoostStack",
+                thread_count,
+                specialized_ops_per_thread,
+                iterations,
+                repeats
+        ));
+    }
+
+    for (const int thread_count : contention_threads) {
+        for (const size_t batch_size : {size_t{64}, size_t{512}}) {
+            append_samples(bench_mt_batched<EagerCasStackAdapter, true>(
+                    "stack",
+                    thread_count,
+                    specialized_ops_per_thread,
+                    batch_size,
+                    repeats
+            ));
+            append_samples(bench_mt_batched<EagerCasStackAdapter, false>(
+                    "stack",
+                    thread_count,
+                    specialized_ops_per_thread,
+                    batch_size,
+                    repeats
+            ));
+            append_samples(bench_mt_batched<UnrolledCasStackAdapter, true>(
+                    "stack_unrolled",
+                    thread_count,
+                    specialized_ops_per_thread,
+                    batch_size,
+                    repeats
+            ));
+            append_samples(bench_mt_batched<BoostStack, false>(
+                    "BoostStack",
+                    thread_count,
+                    specialized_ops_per_thread,
+                    batch_size,
+                    repeats
+            ));
+        }
+    }
+
+    append_samples(bench_promotion_stall("stack", 1'000'000, repeats));
+
+    // Push/pop throughput with and without a thread exporting snapshots of a 64K-deep stack.
+    for (const int thread_count : contention_threads) {
+        for (const bool with_snapshot : {false, true}) {
+            append_samples(bench_mix_under_snapshot<SeraphStack>(
+                    "stack",
+                    thread_count,
+                    65'536,
+                    specialized_ops_per_thread,
+                    with_snapshot,
+                    repeats
+            ));
+            append_samples(bench_mix_under_snapshot<EagerCasStackAdapter>(
+                    "stack_cas",
+                    thread_count,
+                    65'536,
+                    specialized_ops_per_thread,
+                    with_snapshot,
+                    repeats
+            ));
+        }
+    }
+
+    {
+        constexpr int k_wake_rounds = 20;
+        constexpr auto k_idle = std::chrono::milliseconds(10);
+        double wait_cpu_ms = 0.0;
+        double poll_cpu_ms = 0.0;
+        append_samples(bench_wake_latency("stack", true, k_idle, k_wake_rounds, wait_cpu_ms));
+        append_samples(bench_wake_latency("stack_poll", false, k_idle, k_wake_rounds, poll_cpu_ms));
+        std::cout << "Idle consumer CPU over " << k_wake_rounds << " x " << k_idle.count()
+                  << " ms: pop_wait " << std::fixed << std::setprecision(2) << wait_cpu_ms
+                  << " ms, pop() polling " << poll_cpu_ms << " ms\n";
+    }
+
+    for (int mode = 0; mode < 3; ++mode) {
+        append_samples(bench_message_consume("stack", mode, iterations, repeats));
+    }
+
+    const auto churn_stats_before = SeraphStack::node_cache_stats();
+    for (const int thread_count : contention_threads) {
+        append_samples(bench_mt_alloc_churn<EagerCasStackAdapter>(
+                "stack",
+                thread_count,
+                specialized_ops_per_thread,
+                repeats
+        ));
+        append_samples(bench_mt_alloc_churn<BoostStack>(
+                "BoostStack",
+                thread_count,
+                specialized_ops_per_thread,
+                repeats
+        ));
+    }
+    const auto churn_stats_after = SeraphStack::node_cache_stats();
+    const size_t churn_hits = churn_stats_after.hits - churn_stats_before.hits;
+    const size_t churn_misses = churn_stats_after.misses - churn_stats_before.misses;
+    const size_t churn_allocations = churn_hits + churn_misses;
+    std::cout << "Node cache (alloc_churn): " << churn_hits << " hits, " << churn_misses
+              << " misses";
+    if (churn_allocations > 0) {
+        std::cout << " (" << std::fixed << std::setprecision(2)
+                  << 100.0 * static_cast<double>(churn_hits) /
+                             static_cast<double>(churn_allocations)
+                  << "% reused)";
+    }
+    std::cout << "\n";
+
+    report_thread_burst_rss(4, specialized_ops_per_thread, 16);
+
+    const size_t growth_count = quick ? 1'000'000 : 10'000'000;
+    report_growth_latency<SeraphStack>("stack", growth_count);
+    report_growth_latency<ThreadSafeSTLStackAdapter>("std_stack_mutex", growth_count);
+
+    // Pool-style churn on the sharded, tagged-pointer, unrolled and pmr-pool stacks, kept out of the
+    // node cache counters above.
+    for (const int thread_count : contention_threads) {
+        if constexpr (seraph::tagged_pointer_cas_supported<int>) {
+            append_samples(bench_mt_alloc_churn<TaggedCasStackAdapter>(
+                    "stack_tagged",
+                    thread_count,
+                    specialized_ops_per_thread,
+                    repeats
+            ));
+        }
+        append_samples(bench_mt_alloc_churn<UnrolledCasStackAdapter>(
+                "stack_unrolled",
+                thread_count,
+                specialized_ops_per_thread,
+                repeats
+        ));
+        append_samples(bench_mt_alloc_churn<ShardedStack>(
+                "sharded_stack",
+                thread_count,
+                specialized_ops_per_thread,
+                repeats
+        ));
+        append_samples(bench_mt_alloc_churn<PoolCasStackAdapter>(
+                "stack_pmr_pool",
+                thread_count,
+                specialized_ops_per_thread,
+                repeats
+        ));
     }
 #else
     std::cerr << "Boost lockfree stack headers not found; cannot run Boost-only comparison.\n";